@@ -0,0 +1,132 @@
+/**
+ * @file db_profiles.cpp
+ * @brief Read/write throughput of each Db PRAGMA profile.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Builds a synthetic Flight table per profile in a scratch file and times
+ * bulk loading, single-row commits and concurrent page reads.
+ *
+ * Usage: bench_db_profiles [rows] [srcDir] [scratchDir]
+ */
+
+#include "db.h"
+#include "timeutil.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void removeDbFiles(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// departure times spread over one year so keyset seeks land all over the index
+std::string departureFor(int i) {
+    char buf[32];
+    int minutes = (i * 37) % (365 * 24 * 60);
+    int day = minutes / (24 * 60);
+    std::snprintf(buf, sizeof(buf), "2026-%02d-%02dT%02d:%02d:00",
+                  1 + day / 31 % 12, 1 + day % 28, minutes / 60 % 24, minutes % 60);
+    return buf;
+}
+
+FlightInput syntheticFlight(int i, const ReferenceIds& refs) {
+    FlightInput f;
+    f.planeID = refs.planeByModel.begin()->second;
+    f.airlineID = refs.airlineByName.begin()->second;
+    f.originAirportID = 1 + i % 60;
+    f.destinationAirportID = 1 + (i + 7) % 60;
+    f.gate = "G" + std::to_string(i % 80);
+    f.passengerCount = 100 + i % 200;
+    f.departureTime = departureFor(i);
+    return f;
+}
+
+void runProfile(DbProfile profile, int rows, const std::string& srcDir, const std::string& scratchDir) {
+    const std::string path = scratchDir + "/flights_bench_" + dbProfileName(profile) + ".db";
+    removeDbFiles(path);
+
+    double bulkRate = 0, singleRate = 0, readRate = 0;
+    {
+        // flush interval 0: single writes measure one commit each
+        Db db(path, 4, 0, profile);
+        db.initSchema(srcDir + "/schema.sql");
+        db.seedIfEmpty(srcDir + "/seed.sql");
+        auto refs = db.getReferenceIds();
+
+        // 1. bulk load in 10k-row transactions
+        auto start = Clock::now();
+        std::vector<FlightInput> chunk;
+        for (int i = 0; i < rows; ++i) {
+            chunk.push_back(syntheticFlight(i, refs));
+            if (chunk.size() == 10000 || i == rows - 1) {
+                db.createFlights(chunk);
+                chunk.clear();
+            }
+        }
+        bulkRate = rows / secondsSince(start);
+
+        // 2. single-row inserts, one commit each
+        const int singles = 500;
+        start = Clock::now();
+        for (int i = 0; i < singles; ++i) {
+            auto f = syntheticFlight(rows + i, refs);
+            db.createFlight(f.planeID, f.airlineID, f.originAirportID, f.destinationAirportID,
+                            f.gate, f.passengerCount, f.departureTime);
+        }
+        singleRate = singles / secondsSince(start);
+
+        // 3. concurrent 100-row page reads from random keyset positions
+        const int threads = 4, pagesPerThread = 250;
+        std::atomic<int> pages{0};
+        start = Clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]{
+                std::mt19937 rng(t);
+                for (int i = 0; i < pagesPerThread; ++i) {
+                    int total = 0;
+                    std::int64_t key = 0;
+                    timeutil::parseDateTime(departureFor(static_cast<int>(rng() % rows)), key);
+                    FlightCursor after{std::to_string(key), 0};
+                    db.getFlightsPage(100, 0, "departure", "", TimeWindow{}, 0, total, after);
+                    pages++;
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        readRate = pages / secondsSince(start);
+    }
+    removeDbFiles(path);
+
+    std::printf("%-9s %14.0f %16.1f %14.1f\n", dbProfileName(profile), bulkRate, singleRate, readRate);
+}
+
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::string srcDir = argc > 2 ? argv[2] : "src";
+    std::string scratchDir = argc > 3 ? argv[3] : "/tmp";
+
+    std::printf("rows: %d\n", rows);
+    std::printf("%-9s %14s %16s %14s\n", "profile", "bulk rows/s", "single writes/s", "pages/s");
+    for (auto profile : {DbProfile::Durable, DbProfile::Balanced, DbProfile::Fast}) {
+        runProfile(profile, rows, srcDir, scratchDir);
+    }
+    return 0;
+}
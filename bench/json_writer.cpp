@@ -0,0 +1,129 @@
+/**
+ * @file json_writer.cpp
+ * @brief JsonWriter vs crow::json::wvalue for flight list responses.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Serializes the same synthetic page of flights both ways: the wvalue
+ * tree the list handler used to build (then dump), and JsonWriter.
+ *
+ * Usage: bench_json_writer
+ */
+
+#include "jsonwriter.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<FlightItem> syntheticPage(int rows) {
+    std::vector<FlightItem> flights(rows);
+    for (int i = 0; i < rows; ++i) {
+        FlightItem& f = flights[i];
+        f.flightID = 1000 + i;
+        f.airlineName = "Air Canada";
+        f.airlineLogoPath = "/assets/logos/aircanada.png";
+        f.plane = "Boeing 787-9";
+        f.planeSpeed = 900;
+        f.gate = "B" + std::to_string(i % 40);
+        f.passengers = 150 + i % 120;
+        f.departureTime = "2026-10-17T14:35:00";
+        f.statusClass = "ontime";
+        f.statusText = "ON TIME";
+        f.progress = 0.25;
+        f.origin = {"Toronto", "YYZ", 43.6777, -79.6248};
+        f.destination = {"Vancouver", "YVR", 49.1967, -123.1815};
+        f.distanceKm = 3361.4876543;
+        f.durationMinutes = 254;
+        f.arrivalTime = "2026-10-17T18:49:00";
+    }
+    return flights;
+}
+
+// The wvalue path as the list handler built it.
+std::string viaWvalue(const std::vector<FlightItem>& flights) {
+    crow::json::wvalue out;
+    std::vector<crow::json::wvalue> flightsList;
+
+    for (const auto& f : flights) {
+        crow::json::wvalue j;
+        j["flightID"] = f.flightID;
+        j["airline"]["name"] = f.airlineName;
+        j["airline"]["logoPath"] = f.airlineLogoPath;
+        j["plane"] = f.plane;
+        j["gate"] = f.gate;
+        j["passengers"] = f.passengers;
+        j["departureTime"] = f.departureTime;
+        j["status"]["class"] = f.statusClass;
+        j["status"]["text"] = f.statusText;
+        j["progress"] = f.progress;
+        j["origin"]["city"] = f.origin.city;
+        j["origin"]["code"] = f.origin.code;
+        j["origin"]["latitude"] = f.origin.latitude;
+        j["origin"]["longitude"] = f.origin.longitude;
+        j["destination"]["city"] = f.destination.city;
+        j["destination"]["code"] = f.destination.code;
+        j["destination"]["latitude"] = f.destination.latitude;
+        j["destination"]["longitude"] = f.destination.longitude;
+        int h = f.durationMinutes / 60;
+        int m = f.durationMinutes % 60;
+        j["distanceKm"] = f.distanceKm;
+        j["durationMinutes"] = f.durationMinutes;
+        j["durationText"] = std::to_string(h) + "h " + std::to_string(m) + "m";
+        j["arrivalTime"] = f.arrivalTime;
+        flightsList.push_back(std::move(j));
+    }
+
+    out["page"] = 1;
+    out["size"] = 100;
+    out["total"] = static_cast<int>(flights.size());
+    out["totalPages"] = 1;
+    out["nextCursor"] = nullptr;
+    out["flights"] = std::move(flightsList);
+    return out.dump();
+}
+
+std::string viaWriter(const std::vector<FlightItem>& flights) {
+    JsonWriter out(256 + flights.size() * kFlightJsonBytes);
+    out.beginObject();
+    out.key("page");       out.value(1);
+    out.key("size");       out.value(100);
+    out.key("total");      out.value(static_cast<int>(flights.size()));
+    out.key("totalPages"); out.value(1);
+    out.key("nextCursor"); out.null();
+    out.key("flights");
+    out.beginArray();
+    for (const auto& f : flights) writeJson(out, f);
+    out.endArray();
+    out.endObject();
+    return out.take();
+}
+
+template <typename Fn>
+double microsPerCall(Fn fn, const std::vector<FlightItem>& flights, int iterations, std::size_t& bytes) {
+    bytes = fn(flights).size();   // warm-up
+    auto start = Clock::now();
+    std::size_t sink = 0;
+    for (int i = 0; i < iterations; ++i) sink += fn(flights).size();
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    if (sink == 0) std::puts("");
+    return us;
+}
+
+}
+
+int main() {
+    std::printf("%-8s %14s %14s %9s %12s\n", "rows", "wvalue us", "writer us", "speedup", "bytes");
+    for (int rows : {100, 10000}) {
+        auto flights = syntheticPage(rows);
+        int iterations = rows >= 10000 ? 20 : 2000;
+        std::size_t wvBytes = 0, wrBytes = 0;
+        double wv = microsPerCall(viaWvalue, flights, iterations, wvBytes);
+        double wr = microsPerCall(viaWriter, flights, iterations, wrBytes);
+        std::printf("%-8d %14.1f %14.1f %8.1fx %12zu\n", rows, wv, wr, wv / wr, wrBytes);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file timeutil_iso.cpp
+ * @brief timeutil ISO-8601 parse/format vs the stream-based versions.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Checks both implementations agree on a sweep of timestamps, then times
+ * them. The stream versions are the ones timeutil used before.
+ *
+ * Usage: bench_timeutil_iso
+ */
+
+#include "timeutil.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool streamParse(const std::string& iso, std::chrono::system_clock::time_point& out) {
+    std::string s = iso;
+    if (!s.empty() && s.back() == 'Z') s.pop_back();
+    auto dot = s.find('.');
+    if (dot != std::string::npos) s = s.substr(0, dot);
+
+    std::tm tm{};
+    std::istringstream ss(s);
+    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (ss.fail()) return false;
+    out = std::chrono::system_clock::from_time_t(timegm(&tm));
+    return true;
+}
+
+std::string streamFormat(const std::chrono::system_clock::time_point& tp) {
+    std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    std::ostringstream out;
+    out << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+    return out.str();
+}
+
+template <typename Fn>
+double nanosPerCall(Fn fn, std::size_t calls) {
+    auto start = Clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+}
+
+}
+
+int main() {
+    // every ~7.3 hours from 1900 to 2100, plus the fractional/Z variants
+    std::vector<std::string> inputs;
+    for (std::int64_t t = -2208988800; t < 4102444800; t += 26267) {
+        char buf[timeutil::kIso8601UtcLength];
+        std::string s(buf, timeutil::formatIso8601Utc(t, buf));
+        inputs.push_back(s);
+        inputs.push_back(s.substr(0, 19));
+        inputs.push_back(s.substr(0, 19) + ".123Z");
+    }
+    inputs.push_back("2026-02-30T10:00:00");   // rolls over like timegm
+    inputs.push_back("2026-13-01T10:00:00");   // invalid
+    inputs.push_back("not a date");
+
+    std::size_t mismatches = 0;
+    for (const auto& s : inputs) {
+        std::chrono::system_clock::time_point a, b;
+        bool okA = streamParse(s, a), okB = timeutil::parseIso8601Utc(s, b);
+        if (okA != okB || (okA && (a != b || streamFormat(a) != timeutil::formatIso8601Utc(b)))) {
+            if (++mismatches <= 5) std::printf("mismatch: %s\n", s.c_str());
+        }
+    }
+    std::printf("checked %zu inputs, %zu mismatches\n\n", inputs.size(), mismatches);
+
+    std::vector<std::string> times(inputs.begin(), inputs.begin() + 30000);
+    std::vector<std::chrono::system_clock::time_point> tps(times.size());
+    std::int64_t sink = 0;
+
+    double parseOld = nanosPerCall([&]{ for (std::size_t i = 0; i < times.size(); ++i) streamParse(times[i], tps[i]); }, times.size());
+    double parseNew = nanosPerCall([&]{ for (std::size_t i = 0; i < times.size(); ++i) timeutil::parseIso8601Utc(times[i], tps[i]); }, times.size());
+    double formatOld = nanosPerCall([&]{ for (auto& tp : tps) sink += streamFormat(tp).size(); }, tps.size());
+    double formatNew = nanosPerCall([&]{
+        char buf[timeutil::kIso8601UtcLength];
+        for (auto& tp : tps) {
+            auto secs = std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+            sink += timeutil::formatIso8601Utc(secs, buf) - buf;
+        }
+    }, tps.size());
+
+    std::printf("%-8s %12s %12s %9s\n", "op", "stream ns", "timeutil ns", "speedup");
+    std::printf("%-8s %12.1f %12.1f %8.1fx\n", "parse", parseOld, parseNew, parseOld / parseNew);
+    std::printf("%-8s %12.1f %12.1f %8.1fx\n", "format", formatOld, formatNew, formatOld / formatNew);
+    if (sink == 0) std::puts("");
+    return mismatches == 0 ? 0 : 1;
+}
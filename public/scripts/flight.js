@@ -178,7 +178,18 @@ function renderFlights(flights) {
 
   flights.forEach(f => {
     const card = document.createElement("div");
-    card.innerHTML = `
+    card.dataset.flightId = f.flightID;
+    card.innerHTML = flightCardHtml(f);
+
+    container.appendChild(card);
+
+    loadWeather(f.origin.latitude, f.origin.longitude, `w-origin-${f.flightID}`);
+    loadWeather(f.destination.latitude, f.destination.longitude, `w-dest-${f.flightID}`);
+  });
+}
+
+function flightCardHtml(f) {
+  return `
       <div class="flight-card">
         <div class="airline-title">
           <img
@@ -223,12 +234,6 @@ function renderFlights(flights) {
 
       </div>
     `;
-
-    container.appendChild(card);
-
-    loadWeather(f.origin.latitude, f.origin.longitude, `w-origin-${f.flightID}`);
-    loadWeather(f.destination.latitude, f.destination.longitude, `w-dest-${f.flightID}`);
-  });
 }
 
 // Load weather
@@ -256,6 +261,51 @@ function weatherCodeToText(code) {
   return "Storm ⛈️";
 }
 
+// Live updates: patch the cards on this page in place instead of polling.
+// New flights only show up on the next fetch, since their page position
+// depends on the current sort and filters.
+function applyChanges(message) {
+  const deleted = new Set(message.deleted);
+
+  message.flights.forEach(f => {
+    const i = filteredFlights.findIndex(x => x.flightID === f.flightID);
+    if (i < 0) return;
+    filteredFlights[i] = f;
+
+    const card = document.querySelector(`#flightList > [data-flight-id="${f.flightID}"]`);
+    if (!card) return;
+    // keep the weather already loaded for this card
+    const origin = card.querySelector(`#w-origin-${f.flightID}`)?.innerText;
+    const dest = card.querySelector(`#w-dest-${f.flightID}`)?.innerText;
+    card.innerHTML = flightCardHtml(f);
+    if (origin) card.querySelector(`#w-origin-${f.flightID}`).innerText = origin;
+    if (dest) card.querySelector(`#w-dest-${f.flightID}`).innerText = dest;
+  });
+
+  // a card went away: the page shifts, so reload it
+  if (filteredFlights.some(f => deleted.has(f.flightID))) fetchFlights(true);
+}
+
+function connectStream(retryMs = 1000) {
+  const scheme = location.protocol === "https:" ? "wss" : "ws";
+  const ws = new WebSocket(`${scheme}://${location.host}/api/flights/stream`);
+  let opened = false;
+
+  ws.onopen = () => { opened = true; };
+  ws.onmessage = e => {
+    const message = JSON.parse(e.data);
+    if (message.type === "changes") applyChanges(message);
+    else if (message.type === "resync") fetchFlights(true);
+    // flow control: the server holds back clients that fall behind on acks
+    ws.send(JSON.stringify({ type: "ack", seq: message.seq }));
+  };
+  ws.onclose = () => {
+    // back off while the server is unreachable, reset once connected
+    const next = opened ? 1000 : Math.min(retryMs * 2, 30000);
+    setTimeout(() => connectStream(next), opened ? 1000 : retryMs);
+  };
+}
+
 // Event listeners
 searchInput.addEventListener("input", () => {
   currentPage = 1;
@@ -288,4 +338,5 @@ document.addEventListener("click", e => {
 });
 
 // Initial load
-fetchFlights(true);
\ No newline at end of file
+fetchFlights(true);
+connectStream();
\ No newline at end of file
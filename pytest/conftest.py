@@ -13,6 +13,31 @@ def base_url() -> str:
     return _base_url()
 
 
+@pytest.fixture(scope="session")
+def db_path() -> str:
+    """
+    The server's SQLite file, for tests that write behind its back
+    (FLIGHTS_DB_PATH; with docker compose that is ./runtime_db/flights.db).
+    Skips the test when the file isn't reachable from here.
+    """
+    path = os.getenv("FLIGHTS_DB_PATH", "/app/runtime_db/flights.db")
+    if not os.path.isfile(path):
+        pytest.skip(f"server database {path} not reachable (set FLIGHTS_DB_PATH)")
+    return path
+
+
+@pytest.fixture(scope="session")
+def server_bin() -> str:
+    """
+    The server binary (FLIGHTS_SERVER_BIN), run as a second process against
+    the same database; skips the test when it isn't set.
+    """
+    path = os.getenv("FLIGHTS_SERVER_BIN", "")
+    if not path or not os.access(path, os.X_OK):
+        pytest.skip("FLIGHTS_SERVER_BIN not set to the server binary")
+    return path
+
+
 @pytest.fixture(scope="session")
 def http() -> requests.Session:
     s = requests.Session()
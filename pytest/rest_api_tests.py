@@ -1,3 +1,7 @@
+import json
+import subprocess
+import time
+
 import requests
 
 
@@ -160,4 +164,833 @@ def test_INT_API_04_invalid_input_rejected_no_create(base_url, http, reference_i
 
     after = http.get(f"{base_url}/api/flights", timeout=10).json().get("flights", [])
     if before_count is not None and isinstance(after, list):
-        assert len(after) == before_count
\ No newline at end of file
+        assert len(after) == before_count
+
+def test_FUNC_API_06_cursor_pagination(base_url, http):
+    """
+    Keyset pagination: every list response carries nextCursor, following it
+    never repeats a flight, and a malformed cursor is rejected.
+    """
+    r = http.get(f"{base_url}/api/flights?sort=departure", timeout=10)
+    assert r.status_code == 200
+    data = r.json()
+    assert "nextCursor" in data
+
+    if data["nextCursor"] is not None:
+        n = http.get(f"{base_url}/api/flights",
+                     params={"sort": "departure", "cursor": data["nextCursor"]}, timeout=10)
+        assert n.status_code == 200
+        first_ids = {f["flightID"] for f in data["flights"]}
+        assert not first_ids & {f["flightID"] for f in n.json()["flights"]}
+
+    bad = http.get(f"{base_url}/api/flights?cursor=not-a-cursor", timeout=10)
+    assert bad.status_code == 400
+
+
+def test_INT_API_05_search_index_follows_updates(base_url, http, created_flight_id, new_flight_payload):
+    """
+    Integration: the search index is kept in sync with Flight, so a gate
+    change is searchable immediately and the old gate no longer matches.
+    """
+    def search_ids(term):
+        r = http.get(f"{base_url}/api/flights", params={"search": term}, timeout=10)
+        assert r.status_code == 200
+        return {f["flightID"] for f in r.json()["flights"]}
+
+    old_gate = new_flight_payload["gate"]
+    assert created_flight_id in search_ids(old_gate.lower())
+
+    updated = dict(new_flight_payload)
+    updated["gate"] = "SRCH" + old_gate
+    r = http.put(f"{base_url}/api/flights/{created_flight_id}", json=updated, timeout=10)
+    assert r.status_code == 200, r.text
+
+    assert created_flight_id in search_ids(updated["gate"])
+    assert created_flight_id not in search_ids("SRCHX" + old_gate)
+
+
+def test_FUNC_API_07_batch_create_reports_per_item(base_url, http, new_flight_payload):
+    """
+    Batch create: valid items get IDs, invalid ones get errors, in request order.
+    """
+    bad_route = dict(new_flight_payload)
+    bad_route["destinationAirportID"] = bad_route["originAirportID"]
+    bad_plane = dict(new_flight_payload)
+    bad_plane["planeID"] = 999999  # foreign key violation
+
+    batch = [new_flight_payload, bad_route, dict(new_flight_payload), bad_plane]
+    r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=10)
+    assert r.status_code == 201, r.text
+    data = r.json()
+    assert data["created"] == 2
+    assert data["failed"] == 2
+
+    results = data["results"]
+    assert [item["index"] for item in results] == [0, 1, 2, 3]
+    assert isinstance(results[0].get("flightID"), int)
+    assert "must be different" in results[1]["error"]
+    assert isinstance(results[2].get("flightID"), int)
+    assert "error" in results[3]
+
+    for item in (results[0], results[2]):
+        g = http.get(f"{base_url}/api/flights/{item['flightID']}", timeout=10)
+        assert g.status_code == 200
+        assert g.json()["gate"] == new_flight_payload["gate"]
+        http.delete(f"{base_url}/api/flights/{item['flightID']}", timeout=10)
+
+
+def test_FUNC_API_08_ndjson_import(base_url, http):
+    """
+    Streaming import: rows resolve reference names to IDs; bad rows are reported by row number.
+    """
+    planes = http.get(f"{base_url}/api/planes", timeout=10).json()["planes"]
+    airlines = http.get(f"{base_url}/api/airlines", timeout=10).json()["airlines"]
+    airports = http.get(f"{base_url}/api/airports", timeout=10).json()["airports"]
+
+    gate = f"IMP{int(time.time()) % 100000}"
+    row = {
+        "airline": airlines[0]["name"],
+        "plane": planes[0]["model"],
+        "origin": airports[0]["code"],
+        "destination": airports[2]["code"],
+        "gate": gate,
+        "passengerCount": 50,
+        "departureTime": "2026-03-01T08:00:00",
+    }
+    unknown = dict(row, airline="No Such Airline")
+    body = "\n".join(json.dumps(r) for r in (row, unknown, row)) + "\n"
+
+    r = http.post(f"{base_url}/api/import?format=ndjson", data=body, timeout=30)
+    assert r.status_code == 200, r.text
+    data = r.json()
+    assert data["rowsRead"] == 3
+    assert data["rowsImported"] == 2
+    assert data["rowsFailed"] == 1
+    assert data["errors"][0]["row"] == 2
+
+    listed = http.get(f"{base_url}/api/flights", params={"search": gate}, timeout=10).json()["flights"]
+    assert len(listed) == 2
+    for f in listed:
+        assert f["airline"]["name"] == row["airline"]
+        http.delete(f"{base_url}/api/flights/{f['flightID']}", timeout=10)
+
+
+def test_INT_API_06_departure_time_normalized_and_status(base_url, http, new_flight_payload):
+    # the add form sends toISOString(); it is stored in the canonical form
+    soon = time.strftime("%Y-%m-%dT%H:%M:%S.000Z", time.gmtime(time.time() + 10 * 60))
+    payload = dict(new_flight_payload, departureTime=soon)
+    r = http.post(f"{base_url}/api/flights", json=payload, timeout=10)
+    assert r.status_code == 201, r.text
+    flight_id = r.json()["flightID"]
+
+    try:
+        stored = http.get(f"{base_url}/api/flights/{flight_id}", timeout=10).json()
+        assert stored["departureTime"] == soon[:19]
+
+        # a date filter in any accepted form finds it; status is computed in UTC
+        params = {"search": payload["gate"], "date": soon[:10]}
+        listed = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()["flights"]
+        assert [f["flightID"] for f in listed] == [flight_id]
+        assert listed[0]["status"]["class"] == "boarding"
+        assert 0.0 < listed[0]["progress"] < 1.0
+
+        bad = dict(new_flight_payload, departureTime="next tuesday")
+        r = http.post(f"{base_url}/api/flights", json=bad, timeout=10)
+        assert r.status_code == 400
+    finally:
+        http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_INT_API_07_status_sort_spans_pages(base_url, http, new_flight_payload):
+    """
+    sort=status orders the whole result (boarding, on time, departed), not
+    just each page, and cursor and page walks agree.
+    """
+    def at(offset_minutes):
+        return time.strftime("%Y-%m-%dT%H:%M:%S", time.gmtime(time.time() + offset_minutes * 60))
+
+    gate = f"ST{int(time.time()) % 100000}"
+    offsets = [-600 - i for i in range(60)] + [5 + i % 20 for i in range(30)] + [120 + i for i in range(60)]
+    batch = [dict(new_flight_payload, gate=gate, departureTime=at(m)) for m in offsets]
+    r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=30)
+    assert r.status_code == 201, r.text
+    ids = [item["flightID"] for item in r.json()["results"]]
+
+    try:
+        by_page, by_cursor, cursor = [], [], None
+        for page in (1, 2):
+            data = http.get(f"{base_url}/api/flights", params={"search": gate, "page": page}, timeout=10).json()
+            by_page += data["flights"]
+        while True:
+            params = {"search": gate}
+            if cursor:
+                params["cursor"] = cursor
+            data = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()
+            by_cursor += data["flights"]
+            cursor = data["nextCursor"]
+            if cursor is None:
+                break
+
+        assert [f["flightID"] for f in by_page] == [f["flightID"] for f in by_cursor]
+        assert len(by_cursor) == len(ids)
+
+        rank = {"boarding": 0, "ontime": 1, "departed": 2}
+        keys = [(rank[f["status"]["class"]], f["departureTime"], f["flightID"]) for f in by_cursor]
+        assert keys == sorted(keys)
+        assert [k[0] for k in keys] == [0] * 30 + [1] * 60 + [2] * 60
+    finally:
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_FUNC_API_09_departure_time_windows(base_url, http, new_flight_payload):
+    """
+    date=D is [D, D+1 day); from/to give any half-open window.
+    """
+    gate = f"WIN{int(time.time()) % 100000}"
+    times = ["2026-04-10T09:00:00", "2026-04-10T23:59:59", "2026-04-11T00:00:00", "2026-04-12T12:00:00"]
+    batch = [dict(new_flight_payload, gate=gate, departureTime=t) for t in times]
+    r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=10)
+    assert r.status_code == 201, r.text
+    ids = [item["flightID"] for item in r.json()["results"]]
+
+    def listed(**params):
+        data = http.get(f"{base_url}/api/flights",
+                        params=dict(params, search=gate, sort="departure"), timeout=10).json()
+        assert data["total"] == len(data["flights"])
+        return [f["departureTime"] for f in data["flights"]]
+
+    try:
+        assert listed(date="2026-04-10") == times[:2]
+        assert listed(**{"from": "2026-04-10T10:00", "to": "2026-04-11T00:00:01"}) == times[1:3]
+        assert listed(**{"from": "2026-04-11"}) == times[2:]
+        assert listed(to="2026-04-10T09:00:00Z") == []
+        assert listed(date="2026-04-10", to="2026-04-12T12:00:01") == times
+        # empty values (the board always sends date=) are no bound
+        assert listed(date="", **{"from": "", "to": ""}) == times
+        assert http.get(f"{base_url}/api/flights", params={"from": "soon"}, timeout=10).status_code == 400
+    finally:
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_INT_API_08_response_cache_invalidated_by_writes(base_url, http, new_flight_payload):
+    """
+    Repeated identical list requests are served from the cache; a write
+    makes the next one see the new data.
+    """
+    gate = f"RC{int(time.time()) % 100000}"
+    params = {"search": gate, "sort": "departure"}
+
+    def stats():
+        return http.get(f"{base_url}/admin/cache-stats", timeout=10).json()
+
+    first = http.get(f"{base_url}/api/flights", params=params, timeout=10)
+    assert first.status_code == 200
+    assert first.json()["total"] == 0
+
+    before = stats()
+    second = http.get(f"{base_url}/api/flights", params=params, timeout=10)
+    after = stats()
+    # a time-bucket rollover between the two requests can turn the hit into a stale miss
+    assert after["hits"] + after["stale"] > before["hits"] + before["stale"]
+    assert second.json() == first.json()
+
+    r = http.post(f"{base_url}/api/flights", json=dict(new_flight_payload, gate=gate), timeout=10)
+    assert r.status_code == 201, r.text
+    flight_id = r.json()["flightID"]
+    try:
+        data = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()
+        assert data["total"] == 1
+        assert data["flights"][0]["flightID"] == flight_id
+    finally:
+        http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+    data = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()
+    assert data["total"] == 0
+
+
+def test_FUNC_API_10_conditional_get_with_etag(base_url, http, new_flight_payload):
+    """
+    List and reference endpoints send ETags and answer a matching
+    If-None-Match with an empty 304; a write changes the flights tag.
+    """
+    for path in ("/api/planes", "/api/airports", "/api/airlines"):
+        r = http.get(f"{base_url}{path}", timeout=10)
+        assert r.status_code == 200
+        assert "max-age" in r.headers.get("Cache-Control", "")
+        etag = r.headers["ETag"]
+        r = http.get(f"{base_url}{path}", headers={"If-None-Match": etag}, timeout=10)
+        assert r.status_code == 304
+        assert r.content == b""
+
+    gate = f"ET{int(time.time()) % 100000}"
+    params = {"search": gate}
+    r = http.get(f"{base_url}/api/flights", params=params, timeout=10)
+    assert r.status_code == 200
+    etag = r.headers["ETag"]
+
+    r = http.get(f"{base_url}/api/flights", params=params,
+                 headers={"If-None-Match": f'"other", {etag}'}, timeout=10)
+    # 200 only if the status time bucket rolled over in between
+    assert r.status_code in (200, 304)
+    if r.status_code == 304:
+        assert r.headers["ETag"] == etag
+
+    r = http.post(f"{base_url}/api/flights", json=dict(new_flight_payload, gate=gate), timeout=10)
+    assert r.status_code == 201, r.text
+    try:
+        r = http.get(f"{base_url}/api/flights", params=params, headers={"If-None-Match": etag}, timeout=10)
+        assert r.status_code == 200
+        assert r.headers["ETag"] != etag
+        assert r.json()["total"] == 1
+    finally:
+        http.delete(f"{base_url}/api/flights/{r.json()['flights'][0]['flightID']}", timeout=10)
+
+
+def test_FUNC_API_11_response_compression(base_url, http, new_flight_payload):
+    """
+    Large JSON bodies and static text files are compressed for clients that
+    accept it; small bodies and identity-only clients get plain bytes.
+    """
+    gate = f"GZ{int(time.time()) % 100000}"
+    batch = [dict(new_flight_payload, gate=gate) for _ in range(20)]
+    r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=10)
+    assert r.status_code == 201, r.text
+    ids = [item["flightID"] for item in r.json()["results"]]
+
+    try:
+        params = {"search": gate}
+        plain = http.get(f"{base_url}/api/flights", params=params,
+                         headers={"Accept-Encoding": "identity"}, timeout=10)
+        assert "Content-Encoding" not in plain.headers
+
+        for encoding in ("gzip", "deflate"):
+            r = http.get(f"{base_url}/api/flights", params=params,
+                         headers={"Accept-Encoding": encoding}, timeout=10)
+            assert r.headers.get("Content-Encoding") == encoding
+            assert "Accept-Encoding" in r.headers.get("Vary", "")
+            assert r.json()["flights"] == plain.json()["flights"]
+
+        r = http.get(f"{base_url}/api/flights", params=params,
+                     headers={"Accept-Encoding": "gzip;q=0"}, timeout=10)
+        assert "Content-Encoding" not in r.headers
+    finally:
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+    r = http.get(f"{base_url}/api/flights", params={"search": gate},
+                 headers={"Accept-Encoding": "gzip"}, timeout=10)
+    assert "Content-Encoding" not in r.headers
+
+    r = http.get(f"{base_url}/scripts/flight.js", headers={"Accept-Encoding": "gzip"}, timeout=10)
+    assert r.status_code == 200
+    assert r.headers.get("Content-Encoding") == "gzip"
+    assert "fetch" in r.text
+
+
+def test_FUNC_API_12_static_files_types_and_validators(base_url, http):
+    """
+    Static files get their content type from the extension and answer
+    If-None-Match / If-Modified-Since with 304.
+    """
+    expected = {
+        "/assets/plane.gif": "image/gif",
+        "/pages/flights.html": "text/html",
+        "/styles/main.css": "text/css",
+        "/scripts/flight.js": "application/javascript",
+    }
+    for path, content_type in expected.items():
+        r = http.get(f"{base_url}{path}", timeout=10)
+        assert r.status_code == 200
+        assert r.headers["Content-Type"].startswith(content_type)
+        etag, modified = r.headers["ETag"], r.headers["Last-Modified"]
+
+        r = http.get(f"{base_url}{path}", headers={"If-None-Match": etag}, timeout=10)
+        assert r.status_code == 304
+        assert r.content == b""
+        r = http.get(f"{base_url}{path}", headers={"If-Modified-Since": modified}, timeout=10)
+        assert r.status_code == 304
+        r = http.get(f"{base_url}{path}", headers={"If-None-Match": '"stale"', "If-Modified-Since": modified},
+                     timeout=10)
+        assert r.status_code == 200
+
+    assert http.get(f"{base_url}/pages/missing.html", timeout=10).status_code == 404
+
+
+def _ws_connect(base_url, path):
+    """Opens a WebSocket with the stdlib (the tests have no websocket dependency)."""
+    import base64
+    import os
+    import socket
+    from urllib.parse import urlparse
+
+    url = urlparse(base_url)
+    sock = socket.create_connection((url.hostname, url.port or 80), timeout=10)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall((f"GET {path} HTTP/1.1\r\nHost: {url.netloc}\r\nUpgrade: websocket\r\n"
+                  f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n").encode())
+    head = b""
+    while b"\r\n\r\n" not in head:
+        head += sock.recv(1)
+    assert b" 101 " in head.split(b"\r\n")[0], head
+    return sock
+
+
+def _ws_recv_json(sock):
+    """Reads one unfragmented text frame from the server."""
+    def read(n):
+        buf = b""
+        while len(buf) < n:
+            chunk = sock.recv(n - len(buf))
+            assert chunk, "connection closed"
+            buf += chunk
+        return buf
+
+    b0, b1 = read(2)
+    length = b1 & 0x7F
+    if length == 126:
+        length = int.from_bytes(read(2), "big")
+    elif length == 127:
+        length = int.from_bytes(read(8), "big")
+    payload = read(length)
+    assert b0 & 0x0F == 0x1, f"unexpected opcode {b0 & 0x0F}"
+    return json.loads(payload)
+
+
+def _ws_send_json(sock, message):
+    """Sends one masked text frame (client frames must be masked)."""
+    import os
+    payload = json.dumps(message).encode()
+    assert len(payload) < 126
+    mask = os.urandom(4)
+    sock.sendall(bytes([0x81, 0x80 | len(payload)]) + mask
+                 + bytes(b ^ mask[i % 4] for i, b in enumerate(payload)))
+
+
+def test_INT_API_09_flight_stream_snapshot_and_changes(base_url, http, new_flight_payload):
+    """
+    The stream sends a snapshot on connect, then created/updated flights
+    and deleted IDs as they happen.
+    """
+    sock = _ws_connect(base_url, "/api/flights/stream")
+    try:
+        snapshot = _ws_recv_json(sock)
+        assert snapshot["type"] == "snapshot"
+        assert isinstance(snapshot["flights"], list)
+
+        def next_change():
+            while True:
+                message = _ws_recv_json(sock)
+                if message["type"] != "resync":
+                    assert message["type"] == "changes"
+                    return message
+
+        r = http.post(f"{base_url}/api/flights", json=new_flight_payload, timeout=10)
+        assert r.status_code == 201, r.text
+        flight_id = r.json()["flightID"]
+
+        message = next_change()
+        flights = {f["flightID"]: f for f in message["flights"]}
+        assert flight_id in flights
+        assert flights[flight_id]["gate"] == new_flight_payload["gate"]
+        assert "status" in flights[flight_id]
+
+        assert http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10).status_code in (200, 204)
+        message = next_change()
+        while flight_id not in message["deleted"]:
+            message = next_change()
+    finally:
+        sock.close()
+
+
+def test_INT_API_10_flight_stream_status_flips_at_tick_boundaries(base_url, http, new_flight_payload):
+    """
+    Flights whose departure (or boarding start) falls on any second are
+    pushed with their new status once it flips, including the second a
+    status tick lands on. Six consecutive seconds always contain one tick
+    (every 5 s).
+    """
+    import datetime
+
+    sock = _ws_connect(base_url, "/api/flights/stream")
+    ids = []
+    try:
+        assert _ws_recv_json(sock)["type"] == "snapshot"
+
+        start = int(time.time()) + 3
+        seconds = [start + i for i in range(6)]
+
+        def at(epoch):
+            return datetime.datetime.fromtimestamp(epoch, datetime.timezone.utc).strftime("%Y-%m-%dT%H:%M:%S")
+
+        # departing (boarding -> departed) and boarding opening (on time -> boarding)
+        times = [at(t) for t in seconds] + [at(t + 30 * 60) for t in seconds]
+        batch = [dict(new_flight_payload, gate="TICK", departureTime=t) for t in times]
+        r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=10)
+        assert r.status_code == 201, r.text
+        ids = [item["flightID"] for item in r.json()["results"]]
+        expected = {flight_id: ("DEPARTED" if i < 6 else "BOARDING") for i, flight_id in enumerate(ids)}
+
+        status = {}
+        deadline = time.time() + 25
+        while time.time() < deadline and any(status.get(i) != s for i, s in expected.items()):
+            sock.settimeout(max(0.1, deadline - time.time()))
+            try:
+                message = _ws_recv_json(sock)
+            except OSError:   # timed out: the assert below shows which flip was missed
+                break
+            assert message["type"] != "resync"
+            for f in message.get("flights", []):
+                status[f["flightID"]] = f["status"]["text"]
+        assert {i: status.get(i) for i in ids} == expected
+    finally:
+        sock.close()
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_INT_API_11_flight_stream_holds_back_unacknowledged_subscriber(base_url, http, new_flight_payload):
+    """
+    A subscriber that stops acknowledging gets one resync once its
+    unacknowledged bytes pass the cap, then nothing until it acks; acking
+    brings it back (with another resync for what it missed).
+    """
+    def stats():
+        return http.get(f"{base_url}/admin/stream-stats", timeout=10).json()
+
+    def create(count):
+        batch = [dict(new_flight_payload, gate="LAG") for _ in range(count)]
+        r = http.post(f"{base_url}/api/flights/batch", json=batch, timeout=30)
+        assert r.status_code == 201, r.text
+        created = [item["flightID"] for item in r.json()["results"]]
+        ids.extend(created)
+        return created
+
+    sock = _ws_connect(base_url, "/api/flights/stream")
+    ids = []
+    try:
+        assert _ws_recv_json(sock)["type"] == "snapshot"
+
+        # never ack: each batch adds one changes message until the cap is hit
+        message = None
+        for _ in range(10):
+            create(200)
+            message = _ws_recv_json(sock)
+            if message["type"] == "resync":
+                break
+            assert message["type"] == "changes"
+        assert message["type"] == "resync"
+        assert stats()["lagging"] >= 1
+
+        # held back: nothing is queued for it
+        create(1)
+        sock.settimeout(1.0)
+        try:
+            extra = _ws_recv_json(sock)
+        except OSError:
+            extra = None
+        assert extra is None, extra
+        sock.settimeout(10)
+
+        # acking the resync: changes went by meanwhile, so one more resync
+        _ws_send_json(sock, {"type": "ack", "seq": message["seq"]})
+        again = _ws_recv_json(sock)
+        assert again["type"] == "resync"
+        _ws_send_json(sock, {"type": "ack", "seq": again["seq"]})
+
+        # caught up: changes flow again
+        (flight_id,) = create(1)
+        message = _ws_recv_json(sock)
+        while message["type"] != "changes" or flight_id not in [f["flightID"] for f in message["flights"]]:
+            message = _ws_recv_json(sock)
+    finally:
+        sock.close()
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_INT_API_12_out_of_process_import_is_served(base_url, http, server_bin, tmp_path):
+    """
+    `server --import` runs in its own process: once it commits, the live
+    server stops answering 304 for the old board, lists the new rows and
+    streams them to subscribers.
+    """
+    airlines = http.get(f"{base_url}/api/airlines", timeout=10).json()["airlines"]
+    planes = http.get(f"{base_url}/api/planes", timeout=10).json()["planes"]
+    airports = http.get(f"{base_url}/api/airports", timeout=10).json()["airports"]
+
+    gate = f"EXT{int(time.time()) % 100000}"
+    params = {"search": gate, "sort": "departure"}
+    before = http.get(f"{base_url}/api/flights", params=params, timeout=10)
+    assert before.status_code == 200 and before.json()["flights"] == []
+    etag = before.headers["ETag"]
+    # the tag also carries the time bucket: retry if one rolled over in between
+    for _ in range(3):
+        again = http.get(f"{base_url}/api/flights", params=params, headers={"If-None-Match": etag}, timeout=10)
+        if again.status_code == 304:
+            break
+        etag = again.headers["ETag"]
+    assert again.status_code == 304
+
+    row = {
+        "airline": airlines[0]["name"],
+        "plane": planes[0]["model"],
+        "origin": airports[0]["code"],
+        "destination": airports[1]["code"],
+        "gate": gate,
+        "passengerCount": 42,
+        "departureTime": "2026-04-01T09:30:00",
+    }
+    schedule = tmp_path / "schedule.ndjson"
+    schedule.write_text(json.dumps(row) + "\n" + json.dumps(row) + "\n")
+
+    sock = _ws_connect(base_url, "/api/flights/stream")
+    ids = []
+    try:
+        snapshot = _ws_recv_json(sock)
+        assert snapshot["type"] == "snapshot"
+        _ws_send_json(sock, {"type": "ack", "seq": snapshot["seq"]})
+
+        done = subprocess.run([server_bin, "--import", str(schedule)],
+                              capture_output=True, text=True, timeout=60)
+        assert done.returncode == 0, done.stderr
+        assert json.loads(done.stdout)["rowsImported"] == 2
+
+        after = http.get(f"{base_url}/api/flights", params=params,
+                         headers={"If-None-Match": etag}, timeout=10)
+        assert after.status_code == 200, after.status_code
+        assert after.headers["ETag"] != etag
+        listed = after.json()["flights"]
+        ids = [f["flightID"] for f in listed]
+        assert len(ids) == 2
+
+        streamed = set()
+        while not streamed.issuperset(ids):
+            message = _ws_recv_json(sock)
+            assert message["type"] == "changes", message["type"]
+            streamed.update(f["flightID"] for f in message["flights"])
+            _ws_send_json(sock, {"type": "ack", "seq": message["seq"]})
+    finally:
+        sock.close()
+        for flight_id in ids:
+            http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_INT_API_13_response_cache_invalidated_by_other_process(base_url, http, db_path, created_flight_id,
+                                                               new_flight_payload):
+    """
+    A cached list body goes stale when another process writes the
+    database, not only on this server's own writes.
+    """
+    import sqlite3
+
+    params = {"search": new_flight_payload["gate"], "sort": "departure"}
+    first = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()
+    assert [f["passengers"] for f in first["flights"]] == [new_flight_payload["passengerCount"]]
+    assert http.get(f"{base_url}/api/flights", params=params, timeout=10).json() == first
+
+    with sqlite3.connect(db_path, timeout=10) as conn:
+        conn.execute("UPDATE Flight SET passengerCount = 7 WHERE flightID = ?", (created_flight_id,))
+
+    data = http.get(f"{base_url}/api/flights", params=params, timeout=10).json()
+    assert [f["passengers"] for f in data["flights"]] == [7]
+
+
+def test_FUNC_API_13_changes_since_version(base_url, http, new_flight_payload):
+    """
+    /api/flights/changes returns only flights changed after `since`,
+    with deletes as tombstones and a high-water mark to continue from.
+    """
+    start = http.get(f"{base_url}/api/flights/changes", params={"since": 1 << 40}, timeout=10).json()
+    since = start["version"]
+    assert start["flights"] == [] and start["deleted"] == []
+
+    r = http.post(f"{base_url}/api/flights", json=new_flight_payload, timeout=10)
+    assert r.status_code == 201, r.text
+    flight_id = r.json()["flightID"]
+
+    data = http.get(f"{base_url}/api/flights/changes", params={"since": since}, timeout=10).json()
+    assert [f["flightID"] for f in data["flights"]] == [flight_id]
+    assert data["version"] > since
+    assert data["more"] is False
+    created_version = data["version"]
+
+    # nothing new since the high-water mark
+    data = http.get(f"{base_url}/api/flights/changes", params={"since": created_version}, timeout=10).json()
+    assert data["flights"] == [] and data["version"] == created_version
+
+    http.put(f"{base_url}/api/flights/{flight_id}", json=dict(new_flight_payload, gate="CHG"), timeout=10)
+    http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+    # update then delete collapse into one tombstone
+    data = http.get(f"{base_url}/api/flights/changes", params={"since": created_version}, timeout=10).json()
+    assert data["flights"] == []
+    assert data["deleted"] == [flight_id]
+
+    data = http.get(f"{base_url}/api/flights/changes", params={"since": since, "limit": 1}, timeout=10).json()
+    assert data["deleted"] == [flight_id] and data["more"] is False
+
+    assert http.get(f"{base_url}/api/flights/changes", params={"since": "x"}, timeout=10).status_code == 400
+
+
+def test_FUNC_API_14_prometheus_metrics(base_url, http):
+    """
+    /metrics exposes per-route request counters and latency histograms
+    (IDs collapsed into the route label) and Db call timings.
+    """
+    def count(text, prefix):
+        return sum(float(line.rsplit(" ", 1)[1]) for line in text.splitlines() if line.startswith(prefix))
+
+    series = 'http_requests_total{method="GET",route="/api/flights",code="2xx"}'
+    before = count(http.get(f"{base_url}/metrics", timeout=10).text, series)
+
+    assert http.get(f"{base_url}/api/flights", params={"page": 1}, timeout=10).status_code == 200
+    http.get(f"{base_url}/api/flights/999999999", timeout=10)
+
+    r = http.get(f"{base_url}/metrics", timeout=10)
+    assert r.status_code == 200
+    assert r.headers["Content-Type"].startswith("text/plain; version=0.0.4")
+    text = r.text
+
+    assert count(text, series) >= before + 1
+    assert 'route="/api/flights/<int>",code="4xx"' in text
+    assert "/999999999" not in text
+    assert 'http_request_duration_seconds_bucket{method="GET",route="/api/flights",le="+Inf"}' in text
+    assert 'http_requests_in_flight{method="GET",route="/metrics"} 1' in text
+    assert 'db_call_duration_seconds_count{op="getFlightById"}' in text
+
+
+def test_FUNC_API_15_sql_stats_per_statement(base_url, http):
+    """
+    /admin/sql-stats profiles each statement shape: the search and window
+    variants of the list query are separate entries with their own counts.
+    """
+    def find(statements, *fragments):
+        return [s for s in statements if all(f in s["sql"] for f in fragments)]
+
+    search = f"SQ{int(time.time()) % 100000}"
+    for _ in range(3):
+        assert http.get(f"{base_url}/api/flights", params={"search": search, "sort": "gate", "page": 1},
+                        timeout=10).status_code == 200
+
+    statements = http.get(f"{base_url}/admin/sql-stats", timeout=10).json()["statements"]
+    assert statements
+    totals = [s["totalMs"] for s in statements]
+    assert totals == sorted(totals, reverse=True)
+
+    matched = find(statements, "FlightSearch MATCH", "ORDER BY b.gate")
+    assert matched, [s["sql"] for s in statements]
+    entry = matched[0]
+    assert entry["calls"] >= 1
+    assert entry["vmSteps"] > 0
+    assert entry["maxMs"] <= entry["totalMs"]
+    assert "\n" not in entry["sql"] and "  " not in entry["sql"]
+
+    limited = http.get(f"{base_url}/admin/sql-stats", params={"limit": 2}, timeout=10).json()["statements"]
+    assert len(limited) == 2
+
+
+def test_FUNC_API_16_slow_query_log_counters(base_url, http):
+    """
+    /admin/sql-stats reports the slow-query log. With the threshold at 0
+    (FLIGHTS_SLOW_QUERY_MS=0) every statement is logged, off the request path.
+    """
+    def slow():
+        return http.get(f"{base_url}/admin/sql-stats", params={"limit": 0}, timeout=10).json()["slowQueries"]
+
+    before = slow()
+    assert before["thresholdMs"] >= 0
+    assert before["dropped"] == 0
+
+    assert http.get(f"{base_url}/api/flights", params={"search": "SLW", "page": 1}, timeout=10).status_code == 200
+    if before["thresholdMs"] == 0:
+        deadline = time.time() + 5
+        while slow()["logged"] <= before["logged"] and time.time() < deadline:
+            time.sleep(0.1)
+        assert slow()["logged"] > before["logged"]
+
+
+def test_FUNC_API_17_board_initial_request_with_empty_date(base_url, http):
+    """
+    The board's first request carries an empty date (nothing picked yet)
+    and must list flights, not fail validation.
+    """
+    r = http.get(f"{base_url}/api/flights?search=&sort=status&date=&page=1", timeout=10)
+    assert r.status_code == 200, r.text
+    assert "flights" in r.json()
+
+
+def test_FUNC_API_18_import_body_over_limit(base_url, http):
+    """
+    An import body over the (default 32 MiB) limit is refused with 413
+    before any row is imported.
+    """
+    gate = f"BIG{int(time.time()) % 100000}"
+    row = json.dumps({"airline": "x", "plane": "x", "origin": "x", "destination": "x",
+                      "gate": gate, "passengerCount": 1, "departureTime": "2026-03-01T08:00:00"}) + "\n"
+    body = row * (32 * 1024 * 1024 // len(row) + 1)
+
+    r = http.post(f"{base_url}/api/import?format=ndjson", data=body, timeout=60)
+    assert r.status_code == 413, r.text[:200]
+    assert "--import" in r.text
+
+    listed = http.get(f"{base_url}/api/flights", params={"search": gate}, timeout=10).json()["flights"]
+    assert listed == []
+
+
+def test_FUNC_API_19_legacy_departure_time_has_no_derived_status(base_url, http, db_path, reference_ids):
+    """
+    Rows written before departure times were normalized may hold a value
+    that never parses (departureEpoch stays NULL): they list with an empty
+    status and arrival time, not as a 1970 departure.
+    """
+    import sqlite3
+
+    gate = f"LEG{int(time.time()) % 100000}"
+    with sqlite3.connect(db_path, timeout=10) as conn:
+        cur = conn.execute(
+            "INSERT INTO Flight(planeID, airlineID, originAirportID, destinationAirportID,"
+            " gate, passengerCount, departureTime) VALUES (?, ?, ?, ?, ?, 10, 'next tuesday')",
+            (reference_ids["planeID"], reference_ids["airlineID"],
+             reference_ids["originAirportID"], reference_ids["destinationAirportID"], gate))
+        flight_id = cur.lastrowid
+    try:
+        r = http.get(f"{base_url}/api/flights", params={"search": gate, "sort": "departure"}, timeout=10)
+        assert r.status_code == 200, r.text
+        listed = r.json()["flights"]
+        assert [f["flightID"] for f in listed] == [flight_id]
+        f = listed[0]
+        assert f["departureTime"] == "next tuesday"
+        assert f["arrivalTime"] == ""
+        assert f["status"] == {"class": "", "text": ""}
+        assert f["progress"] == 0
+    finally:
+        http.delete(f"{base_url}/api/flights/{flight_id}", timeout=10)
+
+
+def test_FUNC_API_20_reference_etag_follows_edits(base_url, http, db_path):
+    """
+    Reference rows can be edited in place; revalidating afterwards gets
+    the new list, not a 304 for the old one.
+    """
+    import sqlite3
+
+    first = http.get(f"{base_url}/api/airlines", timeout=10)
+    assert first.status_code == 200
+    etag = first.headers["ETag"]
+    airline = first.json()["airlines"][0]
+
+    with sqlite3.connect(db_path, timeout=10) as conn:
+        conn.execute("UPDATE Airline SET logoPath = ? WHERE airlineID = ?",
+                     (airline["logoPath"] + "?v=2", airline["airlineID"]))
+    try:
+        r = http.get(f"{base_url}/api/airlines", headers={"If-None-Match": etag}, timeout=10)
+        assert r.status_code == 200, r.status_code
+        assert r.headers["ETag"] != etag
+        edited = [a for a in r.json()["airlines"] if a["airlineID"] == airline["airlineID"]]
+        assert edited[0]["logoPath"] == airline["logoPath"] + "?v=2"
+    finally:
+        with sqlite3.connect(db_path, timeout=10) as conn:
+            conn.execute("UPDATE Airline SET logoPath = ? WHERE airlineID = ?",
+                         (airline["logoPath"], airline["airlineID"]))
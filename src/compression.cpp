@@ -0,0 +1,123 @@
+/**
+ * @file compression.cpp
+ * @brief Implementation of Content-Encoding negotiation and compression.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "compression.h"
+#include <zlib.h>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace compression {
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+// q-value of one Accept-Encoding element ("gzip;q=0.5"); 1 when absent
+double qValue(std::string_view params) {
+    while (!params.empty()) {
+        auto semi = params.find(';');
+        auto param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+        if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            std::string value(param.substr(2));
+            return std::strtod(value.c_str(), nullptr);
+        }
+    }
+    return 1.0;
+}
+
+}
+
+const char* encodingName(Encoding encoding) {
+    switch (encoding) {
+    case Encoding::Gzip:    return "gzip";
+    case Encoding::Deflate: return "deflate";
+    default:                return "";
+    }
+}
+
+Encoding negotiate(std::string_view acceptEncoding) {
+    double gzip = -1, deflate = -1, any = -1;   // -1: not listed
+
+    while (!acceptEncoding.empty()) {
+        auto comma = acceptEncoding.find(',');
+        auto element = acceptEncoding.substr(0, comma);
+        acceptEncoding = comma == std::string_view::npos ? std::string_view() : acceptEncoding.substr(comma + 1);
+
+        auto semi = element.find(';');
+        auto coding = trim(element.substr(0, semi));
+        double q = semi == std::string_view::npos ? 1.0 : qValue(element.substr(semi + 1));
+
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) gzip = q;
+        else if (equalsIgnoreCase(coding, "deflate")) deflate = q;
+        else if (coding == "*") any = q;
+    }
+
+    if (gzip < 0) gzip = any;
+    if (deflate < 0) deflate = any;
+    if (gzip <= 0 && deflate <= 0) return Encoding::Identity;
+    return gzip >= deflate ? Encoding::Gzip : Encoding::Deflate;
+}
+
+std::string compress(std::string_view data, Encoding encoding, int level) {
+    // windowBits 15 writes a zlib stream, +16 a gzip member
+    const int windowBits = encoding == Encoding::Gzip ? 15 + 16 : 15;
+
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+
+    // one deflate call into a buffer sized for the worst case
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const int rc = deflate(&stream, Z_FINISH);
+    const std::size_t written = stream.total_out;
+    deflateEnd(&stream);
+    if (rc != Z_STREAM_END) throw std::runtime_error("Failed to compress response");
+
+    out.resize(written);
+    return out;
+}
+
+}
+
+void HttpCompression::before_handle(crow::request&, crow::response&, context&) {}
+
+void HttpCompression::after_handle(crow::request& req, crow::response& res, context&) {
+    // static files pick their precompressed variant themselves and clear res.compressed
+    if (!res.compressed || res.body.size() < minBytes || res.code != 200) return;
+    if (!res.get_header_value("Content-Encoding").empty()) return;
+
+    res.set_header("Vary", "Accept-Encoding");
+    const auto encoding = compression::negotiate(req.get_header_value("Accept-Encoding"));
+    if (encoding == compression::Encoding::Identity) return;
+
+    res.body = compression::compress(res.body, encoding, level);
+    res.set_header("Content-Encoding", compression::encodingName(encoding));
+
+    const std::string etag = res.get_header_value("ETag");
+    if (!etag.empty() && etag[0] == '"') res.set_header("ETag", "W/" + etag);
+}
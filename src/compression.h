@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+ * @file compression.h
+ * @brief Content-Encoding negotiation and gzip/deflate compression.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Provides the zlib helpers shared by the static file store and the
+ * HttpCompression middleware that compresses dynamic responses.
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "crow_all.h"
+
+/**
+ * @brief HTTP response compression.
+ */
+namespace compression {
+
+/** @brief A content coding we can produce. */
+enum class Encoding { Identity, Gzip, Deflate };
+
+/** @brief Content-Encoding token for an encoding ("gzip", "deflate", "" for identity). */
+const char* encodingName(Encoding encoding);
+
+/**
+ * @brief Picks the response encoding from an Accept-Encoding header.
+ *
+ * Honours q-values (q=0 refuses a coding) and "*". Prefers gzip over
+ * deflate when both are equally acceptable.
+ * @param acceptEncoding Header value, may be empty.
+ * @return Best acceptable encoding, Identity if none.
+ */
+Encoding negotiate(std::string_view acceptEncoding);
+
+/**
+ * @brief Compresses a buffer.
+ * @param data Input bytes.
+ * @param encoding Gzip or Deflate (zlib wrapper, as HTTP "deflate" means).
+ * @param level zlib level 1-9.
+ * @return Compressed bytes.
+ * @throws std::runtime_error if zlib fails.
+ */
+std::string compress(std::string_view data, Encoding encoding, int level);
+
+}
+
+/**
+ * @brief Crow middleware that compresses response bodies.
+ *
+ * Bodies of at least minBytes are compressed with the encoding the client
+ * prefers. Responses with res.compressed cleared (static files, which pick
+ * a precompressed variant themselves) or an existing Content-Encoding are
+ * left alone. Compressed responses get Vary: Accept-Encoding, and a strong
+ * ETag is turned into a weak one since the bytes differ from the identity
+ * representation.
+ */
+struct HttpCompression {
+    struct context {};
+
+    std::size_t minBytes = 1024;   ///< smaller bodies are sent as is
+    int level = 6;                 ///< zlib compression level
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+};
@@ -9,6 +9,11 @@
 
 
 #include "db.h"
+#include "metrics.h"
+#include "timeutil.h"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -23,18 +28,540 @@ static std::string readWholeFile(const std::string& path) {
     return ss.str();
 }
 
-Db::Db(const std::string& path) {
-    if (sqlite3_open(path.c_str(), &db_) != SQLITE_OK) {
-        throw std::runtime_error("Failed to open database");
+bool parseDbProfile(const std::string& name, DbProfile& out) {
+    if (name == "durable") { out = DbProfile::Durable; return true; }
+    if (name == "balanced") { out = DbProfile::Balanced; return true; }
+    if (name == "fast") { out = DbProfile::Fast; return true; }
+    return false;
+}
+
+const char* dbProfileName(DbProfile profile) {
+    switch (profile) {
+    case DbProfile::Balanced: return "balanced";
+    case DbProfile::Fast:     return "fast";
+    default:                  return "durable";
+    }
+}
+
+// per-connection PRAGMAs for each profile (journal_mode is set once, on the writer)
+static const char* profilePragmas(DbProfile profile) {
+    switch (profile) {
+    case DbProfile::Balanced:
+        return "PRAGMA synchronous = NORMAL;"
+               "PRAGMA cache_size = -32768;"        // 32 MB
+               "PRAGMA mmap_size = 268435456;";     // 256 MB
+    case DbProfile::Fast:
+        return "PRAGMA synchronous = OFF;"
+               "PRAGMA cache_size = -131072;"       // 128 MB
+               "PRAGMA mmap_size = 1073741824;";    // 1 GB
+    default:
+        return "PRAGMA synchronous = FULL;"
+               "PRAGMA cache_size = -8192;"         // 8 MB
+               "PRAGMA mmap_size = 0;";
+    }
+}
+
+// opens one connection with the given flags and the settings every pooled
+// connection shares. Each handle is only ever used by one thread at a time
+// (guarded by the pool), so SQLite's own per-connection mutex is skipped.
+static sqlite3* openConnection(const std::string& path, int flags, DbProfile profile) {
+    sqlite3* handle = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &handle, flags | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        std::string msg = handle ? sqlite3_errmsg(handle) : "out of memory";
+        sqlite3_close(handle);
+        throw std::runtime_error("Failed to open database: " + msg);
     }
+    // wait on a locked database instead of failing straight away
+    sqlite3_busy_timeout(handle, 5000);
+    sqlite3_exec(handle, profilePragmas(profile), nullptr, nullptr, nullptr);
+    return handle;
+}
+
+Db::Db(const std::string& path, int readerCount, int flushIntervalMs, DbProfile profile)
+    : profile_(profile), flushInterval_(std::max(0, flushIntervalMs)) {
+    writer_.handle = openConnection(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, profile_);
+    traceConn(writer_);
+
+    //WAL lets the readers run alongside the writer (setting is persistent in the file)
+    sqlite3_exec(writer_.handle, "PRAGMA journal_mode = WAL;", nullptr, nullptr, nullptr);
     //enable the foreign key constraints
-    sqlite3_exec(db_, "PRAGMA foreign_keys = ON;", nullptr, nullptr, nullptr);
+    sqlite3_exec(writer_.handle, "PRAGMA foreign_keys = ON;", nullptr, nullptr, nullptr);
+
+    readerCount = std::max(1, readerCount);
+    try {
+        for (int i = 0; i < readerCount; ++i) {
+            auto conn = std::make_unique<Conn>();
+            conn->handle = openConnection(path, SQLITE_OPEN_READONLY, profile_);
+            traceConn(*conn);
+            idleReaders_.push_back(conn.get());
+            readers_.push_back(std::move(conn));
+        }
+
+        versionConn_ = openConnection(path, SQLITE_OPEN_READONLY, profile_);
+        if (sqlite3_prepare_v2(versionConn_, "PRAGMA data_version;", -1, &versionStmt_, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Failed to prepare data_version: ") + sqlite3_errmsg(versionConn_));
+        }
+        if (sqlite3_step(versionStmt_) == SQLITE_ROW) seenDataVersion_ = sqlite3_column_int64(versionStmt_, 0);
+        sqlite3_reset(versionStmt_);
+    } catch (...) {
+        sqlite3_finalize(versionStmt_);
+        sqlite3_close(versionConn_);
+        for (auto& r : readers_) closeConn(*r);
+        closeConn(writer_);
+        throw;
+    }
+
+    writerThread_ = std::thread([this]{ writerLoop(); });
 }
 
 // destructor
-// closes the sqlite connection when the Db object is destroyed
+// closes every pooled connection when the Db object is destroyed
 Db::~Db() {
-    if (db_) sqlite3_close(db_);
+    // let the writer drain whatever is still queued before closing
+    {
+        std::lock_guard<std::mutex> lock(writeQueueMutex_);
+        stopWriter_ = true;
+    }
+    writeQueueCv_.notify_one();
+    if (writerThread_.joinable()) writerThread_.join();
+
+    sqlite3_finalize(versionStmt_);
+    sqlite3_close(versionConn_);
+    for (auto& r : readers_) closeConn(*r);
+    closeConn(writer_);
+}
+
+void Db::closeConn(Conn& conn) {
+    for (auto& entry : conn.stmts) sqlite3_finalize(entry.second);
+    conn.stmts.clear();
+    if (conn.handle) sqlite3_close(conn.handle);
+    conn.handle = nullptr;
+}
+
+Db::StatementCacheStats Db::statementCacheStats() const {
+    return {stmtCacheHits_.load(std::memory_order_relaxed),
+            stmtCacheMisses_.load(std::memory_order_relaxed)};
+}
+
+// SQL text with whitespace runs collapsed, comments dropped and string and
+// numeric literals replaced by '?', so statements differing only in
+// formatting or constants share one entry
+static std::string normalizeSql(const std::string& sql) {
+    auto isWord = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    };
+    std::string out;
+    out.reserve(sql.size());
+    bool space = false;
+    for (std::size_t i = 0; i < sql.size();) {
+        const char c = sql[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            space = true;
+            ++i;
+            continue;
+        }
+        if (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-') {
+            i = sql.find('\n', i);
+            if (i == std::string::npos) i = sql.size();
+            space = true;
+            continue;
+        }
+        if (space && !out.empty()) out += ' ';
+        space = false;
+
+        if (c == '\'') {
+            // '' inside a literal is an escaped quote
+            const std::size_t begin = i;
+            for (++i; i < sql.size(); ++i) {
+                if (sql[i] == '\'') {
+                    if (i + 1 < sql.size() && sql[i + 1] == '\'') ++i;
+                    else break;
+                }
+            }
+            i = std::min(i + 1, sql.size());
+            // 'schema'.'table' (as FTS5 writes its shadow tables) names a table, not a value
+            const bool qualified = (!out.empty() && out.back() == '.') || (i < sql.size() && sql[i] == '.');
+            if (qualified) out.append(sql, begin, i - begin);
+            else out += '?';
+        } else if (c >= '0' && c <= '9' && (out.empty() || !isWord(out.back()))) {
+            while (i < sql.size() && (isWord(sql[i]) || sql[i] == '.')) ++i;
+            out += '?';
+        } else if (c == '"') {
+            // quoted identifier: keep as is
+            const std::size_t end = sql.find('"', i + 1);
+            const std::size_t n = end == std::string::npos ? sql.size() - i : end + 1 - i;
+            out.append(sql, i, n);
+            i += n;
+        } else {
+            out += c;
+            ++i;
+        }
+    }
+    while (!out.empty() && (out.back() == ';' || out.back() == ' ')) out.pop_back();
+    return out;
+}
+
+void Db::traceConn(Conn& conn) {
+    conn.owner = this;
+    sqlite3_trace_v2(conn.handle, SQLITE_TRACE_STMT | SQLITE_TRACE_ROW | SQLITE_TRACE_PROFILE,
+                     &Db::traceStatement, &conn);
+}
+
+int Db::traceStatement(unsigned type, void* ctx, void* p, void* x) {
+    auto& conn = *static_cast<Conn*>(ctx);
+    auto* stmt = static_cast<sqlite3_stmt*>(p);
+
+    if (type == SQLITE_TRACE_STMT) {
+        // also fires for each trigger program the statement runs; keep the first start
+        conn.running.try_emplace(stmt, Conn::Running{std::chrono::steady_clock::now(), 0});
+        return 0;
+    }
+    if (type == SQLITE_TRACE_ROW) {
+        auto it = conn.running.find(stmt);
+        if (it != conn.running.end()) ++it->second.rows;
+        return 0;
+    }
+
+    // SQLITE_TRACE_PROFILE: the statement finished. SQLite's own elapsed
+    // time (*x) only has millisecond resolution, so use the steady clock.
+    auto it = conn.running.find(stmt);
+    std::uint64_t elapsedNs = static_cast<std::uint64_t>(*static_cast<sqlite3_int64*>(x));
+    std::uint64_t rows = 0;
+    if (it != conn.running.end()) {
+        elapsedNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - it->second.start).count());
+        rows = it->second.rows;
+        conn.running.erase(it);
+    }
+    const auto vmSteps = static_cast<std::uint64_t>(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1));
+    const auto fullScanSteps = static_cast<std::uint64_t>(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1));
+
+    const char* sql = sqlite3_sql(stmt);
+    if (!sql) return 0;
+
+    SlowQueryLog* slowLog = conn.owner->slowQueryLog_.load(std::memory_order_acquire);
+    if (slowLog && elapsedNs >= static_cast<std::uint64_t>(slowLog->threshold().count())) {
+        // the bindings are only readable now: expand them before the reset clears them
+        SlowQueryLog::Entry entry;
+        entry.at = std::chrono::system_clock::now();
+        entry.sql = sql;
+        if (char* expanded = sqlite3_expanded_sql(stmt)) {
+            entry.expandedSql = expanded;
+            sqlite3_free(expanded);
+        }
+        entry.elapsedNs = elapsedNs;
+        entry.rows = rows;
+        entry.vmSteps = vmSteps;
+        entry.fullScanSteps = fullScanSteps;
+        slowLog->record(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(conn.sqlStatsMutex);
+    auto entry = conn.sqlStats.find(sql);
+    if (entry == conn.sqlStats.end()) {
+        if (conn.sqlStats.size() >= kMaxProfiledStatements) return 0;
+        entry = conn.sqlStats.emplace(sql, SqlStatementStats{}).first;
+    }
+    auto& stats = entry->second;
+    stats.calls++;
+    stats.totalNs += elapsedNs;
+    stats.maxNs = std::max(stats.maxNs, elapsedNs);
+    stats.rows += rows;
+    stats.vmSteps += vmSteps;
+    stats.fullScanSteps += fullScanSteps;
+    return 0;
+}
+
+std::vector<Db::SqlStatementStats> Db::sqlStats() const {
+    std::unordered_map<std::string, SqlStatementStats> merged;
+    auto collect = [&merged](const Conn& conn) {
+        std::lock_guard<std::mutex> lock(conn.sqlStatsMutex);
+        for (const auto& [sql, stats] : conn.sqlStats) {
+            auto& out = merged[normalizeSql(sql)];
+            out.calls += stats.calls;
+            out.totalNs += stats.totalNs;
+            out.maxNs = std::max(out.maxNs, stats.maxNs);
+            out.rows += stats.rows;
+            out.vmSteps += stats.vmSteps;
+            out.fullScanSteps += stats.fullScanSteps;
+        }
+    };
+    collect(writer_);
+    for (const auto& r : readers_) collect(*r);
+
+    std::vector<SqlStatementStats> out;
+    out.reserve(merged.size());
+    for (auto& [sql, stats] : merged) {
+        stats.sql = sql;
+        out.push_back(std::move(stats));
+    }
+    std::sort(out.begin(), out.end(), [](const SqlStatementStats& a, const SqlStatementStats& b) {
+        return a.totalNs > b.totalNs;
+    });
+    return out;
+}
+
+Db::Stmt::~Stmt() {
+    if (!stmt_) return;
+    if (cached_) {
+        // leave it ready for the next caller
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+    } else {
+        sqlite3_finalize(stmt_);
+    }
+}
+
+Db::Lease::Lease(Db& owner, Conn* conn, std::unique_lock<std::mutex> writerLock)
+    : owner_(&owner), conn_(conn), writerLock_(std::move(writerLock)) {}
+
+Db::Lease::Lease(Lease&& other) noexcept
+    : owner_(other.owner_), conn_(other.conn_), writerLock_(std::move(other.writerLock_)) {
+    other.conn_ = nullptr;
+}
+
+Db::Lease::~Lease() {
+    // writer leases just drop the lock; readers go back on the idle list
+    if (conn_ && !writerLock_.owns_lock()) owner_->releaseReader(conn_);
+}
+
+Db::Stmt Db::Lease::prepare(const std::string& sql) {
+    auto it = conn_->stmts.find(sql);
+    if (it != conn_->stmts.end()) {
+        owner_->stmtCacheHits_.fetch_add(1, std::memory_order_relaxed);
+        return Stmt(it->second, true);
+    }
+
+    owner_->stmtCacheMisses_.fetch_add(1, std::memory_order_relaxed);
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(conn_->handle, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return Stmt(nullptr, false);
+    }
+
+    // the cache is full: hand out a one-shot statement instead
+    if (conn_->stmts.size() >= kMaxCachedStatements) return Stmt(stmt, false);
+
+    conn_->stmts.emplace(sql, stmt);
+    return Stmt(stmt, true);
+}
+
+Db::Lease Db::writeConn() {
+    return Lease(*this, &writer_, std::unique_lock<std::mutex>(writerMutex_));
+}
+
+Db::Lease Db::readConn() {
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    poolCv_.wait(lock, [this]{ return !idleReaders_.empty(); });
+    Conn* conn = idleReaders_.back();
+    idleReaders_.pop_back();
+    return Lease(*this, conn, std::unique_lock<std::mutex>());
+}
+
+void Db::releaseReader(Conn* conn) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        idleReaders_.push_back(conn);
+    }
+    poolCv_.notify_one();
+}
+
+void Db::runWrite(std::function<void(Lease&)> work) {
+    WriteJob job;
+    job.work = std::move(work);
+    auto done = job.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(writeQueueMutex_);
+        writeQueue_.push_back(std::move(job));
+    }
+    writeQueueCv_.notify_one();
+
+    // returns once the batch holding this job has committed (or rethrows its error)
+    done.get();
+}
+
+void Db::writerLoop() {
+    for (;;) {
+        std::vector<WriteJob> batch;
+        {
+            std::unique_lock<std::mutex> lock(writeQueueMutex_);
+            writeQueueCv_.wait(lock, [this]{ return stopWriter_ || !writeQueue_.empty(); });
+            if (writeQueue_.empty()) return;   // stopping and drained
+
+            // give concurrent writers one flush interval to join this batch
+            if (flushInterval_.count() > 0 && !stopWriter_) {
+                writeQueueCv_.wait_for(lock, flushInterval_, [this]{
+                    return stopWriter_ || writeQueue_.size() >= kMaxWriteBatch;
+                });
+            }
+
+            const std::size_t n = std::min(writeQueue_.size(), kMaxWriteBatch);
+            batch.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                batch.push_back(std::move(writeQueue_.front()));
+                writeQueue_.pop_front();
+            }
+        }
+        commitBatch(batch);
+    }
+}
+
+std::uint64_t Db::dataVersion() {
+    // our own commits move data_version too, so they bump twice; the second
+    // bump only costs one extra cache miss
+    std::lock_guard<std::mutex> lock(versionMutex_);
+    if (sqlite3_step(versionStmt_) == SQLITE_ROW) {
+        const std::int64_t seen = sqlite3_column_int64(versionStmt_, 0);
+        if (seen != seenDataVersion_) {
+            seenDataVersion_ = seen;
+            bumpDataVersion();
+        }
+    }
+    sqlite3_reset(versionStmt_);
+    return dataVersion_.load(std::memory_order_acquire);
+}
+
+std::int64_t Db::changeVersion() {
+    auto conn = readConn();
+    auto stmt = conn.prepare("SELECT IFNULL(MAX(version), 0) FROM FlightChange;");
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare changeVersion");
+    }
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+}
+
+void Db::commitBatch(std::vector<WriteJob>& batch) {
+    std::vector<std::exception_ptr> errors(batch.size());
+    {
+        auto conn = writeConn();
+        auto exec = [&conn](const char* sql) {
+            return sqlite3_exec(conn, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+        };
+
+        if (!exec("BEGIN IMMEDIATE;")) {
+            auto err = std::make_exception_ptr(std::runtime_error(
+                std::string("Failed to begin write batch: ") + sqlite3_errmsg(conn)));
+            for (auto& job : batch) job.done.set_exception(err);
+            return;
+        }
+
+        // each job runs in its own savepoint so one failure doesn't undo its neighbours
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            exec("SAVEPOINT write_job;");
+            try {
+                batch[i].work(conn);
+                exec("RELEASE write_job;");
+            } catch (...) {
+                errors[i] = std::current_exception();
+                exec("ROLLBACK TO write_job;");
+                exec("RELEASE write_job;");
+            }
+        }
+
+        if (!exec("COMMIT;")) {
+            auto err = std::make_exception_ptr(std::runtime_error(
+                std::string("Failed to commit write batch: ") + sqlite3_errmsg(conn)));
+            exec("ROLLBACK;");
+            for (auto& e : errors) e = err;
+        } else {
+            bumpDataVersion();
+        }
+    }
+
+    // only answer callers once the batch is durable
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (errors[i]) batch[i].done.set_exception(errors[i]);
+        else batch[i].done.set_value();
+    }
+}
+
+// Text column as std::string; NULL reads as empty.
+static std::string columnText(sqlite3_stmt* stmt, int col) {
+    auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return text ? std::string(text, static_cast<std::size_t>(sqlite3_column_bytes(stmt, col))) : std::string();
+}
+
+/** @brief A departure time in both stored forms. */
+struct Departure {
+    std::string text;      // "YYYY-MM-DDTHH:MM:SS"
+    std::int64_t epoch;    // UTC seconds
+};
+
+// Every write path goes through this, so departureTime is always stored
+// in one form and departureEpoch always matches it.
+static bool parseDeparture(const std::string& departureTime, Departure& out) {
+    if (!timeutil::parseDateTime(departureTime, out.epoch)) return false;
+    char buf[timeutil::kDateTimeLength];
+    out.text.assign(buf, timeutil::formatDateTime(out.epoch, buf));
+    return true;
+}
+
+static Departure canonicalDeparture(const std::string& departureTime) {
+    Departure d;
+    if (!parseDeparture(departureTime, d)) {
+        throw std::invalid_argument("Invalid departureTime: " + departureTime);
+    }
+    return d;
+}
+
+// departure window filter over idx_board_departureEpoch
+static std::string windowClause(const TimeWindow& window) {
+    std::string sql;
+    if (window.from) sql += " AND b.departureEpoch >= ?";
+    if (window.to) sql += " AND b.departureEpoch < ?";
+    return sql;
+}
+
+static void bindWindow(sqlite3_stmt* stmt, int& bindIndex, const TimeWindow& window) {
+    if (window.from) sqlite3_bind_int64(stmt, bindIndex++, *window.from);
+    if (window.to) sqlite3_bind_int64(stmt, bindIndex++, *window.to);
+}
+
+// counts UTF-8 code points (continuation bytes don't start a character)
+static std::size_t utf8Length(const std::string& s) {
+    std::size_t n = 0;
+    for (unsigned char c : s) {
+        if ((c & 0xC0) != 0x80) ++n;
+    }
+    return n;
+}
+
+// search filter over the FlightSearch FTS index.
+// Terms of 3+ characters go through the trigram index with MATCH; shorter
+// terms have no trigram to look up, so they fall back to LIKE over the
+// (single, already denormalized) search table.
+static std::string searchClause(const std::string& search) {
+    if (utf8Length(search) >= 3) {
+        return " AND b.flightID IN (SELECT rowid FROM FlightSearch WHERE FlightSearch MATCH :search)";
+    }
+    return R"(
+            AND b.flightID IN (
+                SELECT rowid FROM FlightSearch
+                WHERE airline LIKE :search OR originCity LIKE :search
+                   OR destCity LIKE :search OR originCode LIKE :search
+                   OR destCode LIKE :search OR gate LIKE :search
+                   OR planeModel LIKE :search
+            )
+        )";
+}
+
+// binds the parameter(s) searchClause added, returns the next bind index
+static int bindSearch(sqlite3_stmt* stmt, int bindIndex, const std::string& search) {
+    std::string term;
+    if (utf8Length(search) >= 3) {
+        // quote as one FTS5 phrase so the term is matched literally as a substring
+        term = "\"";
+        for (char c : search) {
+            if (c == '"') term += '"';
+            term += c;
+        }
+        term += '"';
+    } else {
+        term = "%" + search + "%";
+    }
+    // :search may appear several times but is a single parameter slot
+    sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, ":search"), term.c_str(), -1, SQLITE_TRANSIENT);
+    return bindIndex + 1;
 }
 
 // Return all flights
@@ -44,8 +571,36 @@ void Db::execSqlFile(const std::string& path) {
         throw std::runtime_error("Could not open SQL file: " + path);
     }
 
+    auto conn = writeConn();
     char* err = nullptr;
-    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+    if (sqlite3_exec(conn, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        std::string msg = err ? err : "Unknown SQL error";
+        sqlite3_free(err);
+        throw std::runtime_error(msg);
+    }
+    bumpDataVersion();
+}
+
+void Db::addColumnIfMissing(const std::string& table, const std::string& column, const std::string& type) {
+    auto conn = writeConn();
+    bool tableExists = false;
+    {
+        auto stmt = conn.prepare("PRAGMA table_info(" + table + ");");
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare addColumnIfMissing");
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            tableExists = true;
+            if (columnText(stmt, 1) == column) return;
+        }
+    }
+
+    // a missing table is created, with the column, by schema.sql
+    if (!tableExists) return;
+
+    const std::string sql = "ALTER TABLE " + table + " ADD COLUMN " + column + " " + type + ";";
+    char* err = nullptr;
+    if (sqlite3_exec(conn, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
         std::string msg = err ? err : "Unknown SQL error";
         sqlite3_free(err);
         throw std::runtime_error(msg);
@@ -53,14 +608,19 @@ void Db::execSqlFile(const std::string& path) {
 }
 
 void Db::initSchema(const std::string& schemaPath) {
+    // columns added after a table first shipped; CREATE TABLE IF NOT EXISTS
+    // leaves existing tables alone, so older databases get them here
+    addColumnIfMissing("Flight", "departureEpoch", "INTEGER");
+    addColumnIfMissing("FlightBoard", "departureEpoch", "INTEGER");
     execSqlFile(schemaPath);
 }
 
 int Db::getTableCount(const std::string& tableName) {
+    auto conn = readConn();
     std::string sql = "SELECT COUNT(*) FROM " + tableName + ";";
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare COUNT(*) for " + tableName);
     }
 
@@ -69,7 +629,6 @@ int Db::getTableCount(const std::string& tableName) {
         count = sqlite3_column_int(stmt, 0);
     }
 
-    sqlite3_finalize(stmt);
     return count;
 }
 
@@ -86,44 +645,25 @@ void Db::seedIfEmpty(const std::string& seedPath) {
 }
 
 crow::json::wvalue Db::getAllFlights() {
+    static const int series = metrics::dbSeries("getAllFlights");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
     crow::json::wvalue flights = crow::json::wvalue::list();
-    sqlite3_stmt* stmt = nullptr;
 
     const char* sql = R"(
         SELECT
-        f.flightID,
-        f.gate,
-        f.passengerCount,
-        f.departureTime,
-
-        p.model AS planeModel,
-        p.speed AS planeSpeed,
-
-        al.name AS airlineName,
-        al.logoPath AS airlineLogo,
-
-        oa.code AS originCode,
-        da.code AS destCode,
-
-        oc.name AS originCity,
-        dc.name AS destCity,
-
-        oc.latitude  AS originLat,
-        oc.longitude AS originLon,
-        dc.latitude  AS destLat,
-        dc.longitude AS destLon
-
-        FROM Flight f
-        JOIN Plane p   ON f.planeID = p.planeID
-        JOIN Airline al ON f.airlineID = al.airlineID
-        JOIN Airport oa ON f.originAirportID = oa.airportID
-        JOIN Airport da ON f.destinationAirportID = da.airportID
-        JOIN Cities oc  ON oa.cityID = oc.cityID
-        JOIN Cities dc  ON da.cityID = dc.cityID
-        ORDER BY f.departureTime;
+        flightID, gate, passengerCount, departureTime,
+        planeModel, planeSpeed,
+        airlineName, airlineLogo,
+        originCode, destCode,
+        originCity, destCity,
+        originLat, originLon, destLat, destLon
+        FROM FlightBoard
+        ORDER BY departureEpoch, flightID;
     )";
 
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getAllFlights");
     }
 
@@ -156,307 +696,487 @@ crow::json::wvalue Db::getAllFlights() {
         i++;
     }
 
-    sqlite3_finalize(stmt);
     return flights;
 }
 
 int Db::getFlightsCount(const std::string& search,
-                        const std::string& date) {
-    sqlite3_stmt* stmt = nullptr;
+                        const TimeWindow& window) {
+    static const int series = metrics::dbSeries("getFlightsCount");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
+    return countFlights(conn, search, window);
+}
+
+int Db::countFlights(Lease& conn, const std::string& search, const TimeWindow& window) {
+    // the version is read before counting: if a write lands in between, the
+    // entry is stored under the older version and simply recounted next time
+    const std::uint64_t version = dataVersion();
+    std::string key = search;
+    key += '\x1f';
+    if (window.from) key += std::to_string(*window.from);
+    key += '\x1f';
+    if (window.to) key += std::to_string(*window.to);
+    {
+        std::lock_guard<std::mutex> lock(countCacheMutex_);
+        auto it = countCache_.find(key);
+        if (it != countCache_.end() && it->second.version == version) return it->second.count;
+    }
 
     std::string sql = R"(
         SELECT COUNT(*)
-        FROM Flight f
-        JOIN Plane p   ON f.planeID = p.planeID
-        JOIN Airline al ON f.airlineID = al.airlineID
-        JOIN Airport oa ON f.originAirportID = oa.airportID
-        JOIN Airport da ON f.destinationAirportID = da.airportID
-        JOIN Cities oc  ON oa.cityID = oc.cityID
-        JOIN Cities dc  ON da.cityID = dc.cityID
+        FROM FlightBoard b
         WHERE 1=1
     )";
 
     if (!search.empty()) {
-        sql += R"(
-            AND (
-                LOWER(al.name) LIKE LOWER(?)
-                OR LOWER(oc.name) LIKE LOWER(?)
-                OR LOWER(dc.name) LIKE LOWER(?)
-                OR LOWER(oa.code) LIKE LOWER(?)
-                OR LOWER(da.code) LIKE LOWER(?)
-                OR LOWER(f.gate) LIKE LOWER(?)
-                OR LOWER(p.model) LIKE LOWER(?)
-            )
-        )";
+        sql += searchClause(search);
     }
 
-    if (!date.empty()) {
-        sql += " AND f.departureTime BETWEEN datetime(?) AND datetime(?, '+1 day')";
-    }
+    sql += windowClause(window);
 
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getFlightsCount");
     }
 
     int bindIndex = 1;
 
     if (!search.empty()) {
-        std::string pattern = "%" + search + "%";
-        for (int i = 0; i < 7; ++i) {
-            sqlite3_bind_text(stmt, bindIndex++, pattern.c_str(), -1, SQLITE_TRANSIENT);
-        }
+        bindIndex = bindSearch(stmt, bindIndex, search);
     }
 
-    if (!date.empty()) {
-        sqlite3_bind_text(stmt, bindIndex++, date.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, bindIndex++, date.c_str(), -1, SQLITE_TRANSIENT);
-    }
+    bindWindow(stmt, bindIndex, window);
 
     int count = 0;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         count = sqlite3_column_int(stmt, 0);
     }
 
-    sqlite3_finalize(stmt);
+    std::lock_guard<std::mutex> lock(countCacheMutex_);
+    if (countCache_.size() >= kMaxCachedCounts) countCache_.clear();
+    countCache_[key] = CachedCount{version, count};
     return count;
 }
 
-crow::json::wvalue Db::getFlightsPage(int limit, int offset,
-                                      const std::string& sort,
-                                      const std::string& search,
-                                      const std::string& date) {
-    crow::json::wvalue flights = crow::json::wvalue::list();
-    sqlite3_stmt* stmt = nullptr;
-
-    std::string orderBy = "f.departureTime";
-    if (sort == "gate") orderBy = "f.gate";
-
-    std::string sql = R"(
-        SELECT
-        f.flightID,
-        f.gate,
-        f.passengerCount,
-        f.departureTime,
-
-        p.model,
-        p.speed,
-
-        al.name,
-        al.logoPath,
-
-        oa.code,
-        da.code,
-
-        oc.name,
-        dc.name,
-
-        oc.latitude,
-        oc.longitude,
-        dc.latitude,
-        dc.longitude
-
-        FROM Flight f
-        JOIN Plane p   ON f.planeID = p.planeID
-        JOIN Airline al ON f.airlineID = al.airlineID
-        JOIN Airport oa ON f.originAirportID = oa.airportID
-        JOIN Airport da ON f.destinationAirportID = da.airportID
-        JOIN Cities oc  ON oa.cityID = oc.cityID
-        JOIN Cities dc  ON da.cityID = dc.cityID
-        WHERE 1=1
-    )";
+// FlightBoard columns read into a FlightItem by readBoardRow, in order
+static const char* const kBoardColumns = R"(
+        b.flightID, b.gate, b.passengerCount, b.departureTime,
+        b.planeModel, b.planeSpeed,
+        b.airlineName, b.airlineLogo,
+        b.originCode, b.destCode,
+        b.originCity, b.destCity,
+        b.originLat, b.originLon, b.destLat, b.destLon,
+        b.departureEpoch)";
+
+static void readBoardRow(sqlite3_stmt* stmt, FlightItem& f) {
+    f.flightID = sqlite3_column_int(stmt, 0);
+    f.gate = columnText(stmt, 1);
+    f.passengers = sqlite3_column_int(stmt, 2);
+    f.departureTime = columnText(stmt, 3);
+
+    f.plane = columnText(stmt, 4);
+    f.planeSpeed = sqlite3_column_int(stmt, 5);
+
+    f.airlineName = columnText(stmt, 6);
+    f.airlineLogoPath = columnText(stmt, 7);
+
+    f.origin.code = columnText(stmt, 8);
+    f.destination.code = columnText(stmt, 9);
+
+    f.origin.city = columnText(stmt, 10);
+    f.destination.city = columnText(stmt, 11);
+
+    f.origin.latitude = sqlite3_column_double(stmt, 12);
+    f.origin.longitude = sqlite3_column_double(stmt, 13);
+    f.destination.latitude = sqlite3_column_double(stmt, 14);
+    f.destination.longitude = sqlite3_column_double(stmt, 15);
+
+    f.hasDepartureEpoch = sqlite3_column_type(stmt, 16) != SQLITE_NULL;
+    f.departureEpoch = f.hasDepartureEpoch ? sqlite3_column_int64(stmt, 16) : 0;
+}
 
+std::vector<FlightItem> Db::getFlightsPage(int limit, int offset,
+                                           const std::string& sort,
+                                           const std::string& search,
+                                           const TimeWindow& window,
+                                           std::int64_t now,
+                                           int& total,
+                                           const std::optional<FlightCursor>& after) {
+    static const int series = metrics::dbSeries("getFlightsPage");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
+    std::vector<FlightItem> flights;
+    flights.reserve(limit > 0 ? limit : 0);
+
+    std::string filters;
     if (!search.empty()) {
-        sql += R"(
-            AND (
-                LOWER(al.name) LIKE LOWER(?)
-                OR LOWER(oc.name) LIKE LOWER(?)
-                OR LOWER(dc.name) LIKE LOWER(?)
-                OR LOWER(oa.code) LIKE LOWER(?)
-                OR LOWER(da.code) LIKE LOWER(?)
-                OR LOWER(f.gate) LIKE LOWER(?)
-                OR LOWER(p.model) LIKE LOWER(?)
-            )
-        )";
+        filters += searchClause(search);
     }
+    filters += windowClause(window);
+
+    std::string sql;
+    if (sort == "status") {
+        // Boarding, then on time, then departed: three departure-index range
+        // scans, each already in (departureEpoch, flightID) order and capped at
+        // the rows the page can use, so only their union is sorted.
+        static const char* const kSegmentRanges[kStatusSegments] = {
+            " AND b.departureEpoch >= ? AND b.departureEpoch < ?",   // [now, boarding closes)
+            " AND b.departureEpoch >= ?",                             // boarding closes onward
+            " AND b.departureEpoch < ?",                              // before now
+        };
+
+        const int firstSegment = after ? after->segment : 0;
+        for (int seg = firstSegment; seg < kStatusSegments; ++seg) {
+            if (!sql.empty()) sql += " UNION ALL ";
+            sql += "SELECT * FROM (SELECT ";
+            sql += kBoardColumns;
+            sql += ", " + std::to_string(seg) + " AS segment FROM FlightBoard b WHERE 1=1";
+            sql += filters;
+            sql += kSegmentRanges[seg];
+            if (after && seg == after->segment) sql += " AND (b.departureEpoch, b.flightID) > (?, ?)";
+            sql += " ORDER BY b.departureEpoch, b.flightID LIMIT ?)";
+        }
+        sql += " ORDER BY segment, departureEpoch, flightID LIMIT ? OFFSET ?;";
+    } else {
+        std::string orderBy = "b.departureEpoch";
+        if (sort == "gate") orderBy = "b.gate";
+
+        sql = "SELECT ";
+        sql += kBoardColumns;
+        sql += " FROM FlightBoard b WHERE 1=1";
+        sql += filters;
+
+        // keyset seek: (sort key, flightID) matches the index order, since
+        // flightID is the rowid every index ends with
+        if (after) {
+            sql += " AND (" + orderBy + ", b.flightID) > (?, ?)";
+        }
 
-    if (!date.empty()) {
-        sql += " AND f.departureTime BETWEEN datetime(?) AND datetime(?, '+1 day')";
+        sql += " ORDER BY " + orderBy + ", b.flightID LIMIT ? OFFSET ?;";
     }
 
-    sql += " ORDER BY " + orderBy + " LIMIT ? OFFSET ?;";
-
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getFlightsPage");
     }
 
     int bindIndex = 1;
 
     if (!search.empty()) {
-        std::string pattern = "%" + search + "%";
-        for (int i = 0; i < 7; ++i) {
-            sqlite3_bind_text(stmt, bindIndex++, pattern.c_str(), -1, SQLITE_TRANSIENT);
-        }
+        bindIndex = bindSearch(stmt, bindIndex, search);
     }
 
-    if (!date.empty()) {
-        sqlite3_bind_text(stmt, bindIndex++, date.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, bindIndex++, date.c_str(), -1, SQLITE_TRANSIENT);
+    // departure and status cursors hold departureEpoch in decimal
+    auto bindAfter = [&]() {
+        if (sort == "gate") sqlite3_bind_text(stmt, bindIndex++, after->key.c_str(), -1, SQLITE_TRANSIENT);
+        else sqlite3_bind_int64(stmt, bindIndex++, std::strtoll(after->key.c_str(), nullptr, 10));
+        sqlite3_bind_int(stmt, bindIndex++, after->flightID);
+    };
+
+    if (sort == "status") {
+        const std::int64_t boardingCloses = now + kBoardingSeconds;
+
+        const int firstSegment = after ? after->segment : 0;
+        for (int seg = firstSegment; seg < kStatusSegments; ++seg) {
+            bindWindow(stmt, bindIndex, window);
+
+            if (seg == 0) {
+                sqlite3_bind_int64(stmt, bindIndex++, now);
+                sqlite3_bind_int64(stmt, bindIndex++, boardingCloses);
+            } else if (seg == 1) {
+                sqlite3_bind_int64(stmt, bindIndex++, boardingCloses);
+            } else {
+                sqlite3_bind_int64(stmt, bindIndex++, now);
+            }
+
+            if (after && seg == after->segment) bindAfter();
+
+            // a segment can contribute at most offset + limit rows to the page
+            sqlite3_bind_int64(stmt, bindIndex++, static_cast<std::int64_t>(offset) + limit);
+        }
+    } else {
+        bindWindow(stmt, bindIndex, window);
+        if (after) bindAfter();
     }
 
     sqlite3_bind_int(stmt, bindIndex++, limit);
     sqlite3_bind_int(stmt, bindIndex++, offset);
 
-    int i = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        auto& flight = flights[i];
+        readBoardRow(stmt, flights.emplace_back());
+    }
 
-        flight["flightID"] = sqlite3_column_int(stmt, 0);
-        flight["gate"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        flight["passengers"] = sqlite3_column_int(stmt, 2);
-        flight["departureTime"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    // same lease as the page itself; usually a cache hit
+    total = countFlights(conn, search, window);
+    return flights;
+}
 
-        flight["plane"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-        flight["planeSpeed"] = sqlite3_column_int(stmt, 5);
+std::vector<FlightItem> Db::getBoardFlights(const std::vector<int>& ids) {
+    static const int series = metrics::dbSeries("getBoardFlights");
+    metrics::DbTimer timer(series);
+    std::vector<FlightItem> flights;
+    if (ids.empty()) return flights;
+
+    // the IDs go in as one JSON array so any count shares one cached statement
+    std::string list = "[";
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (i) list += ',';
+        list += std::to_string(ids[i]);
+    }
+    list += ']';
 
-        flight["airline"]["name"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-        flight["airline"]["logoPath"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
+    auto conn = readConn();
+    std::string sql = "SELECT ";
+    sql += kBoardColumns;
+    sql += " FROM FlightBoard b WHERE b.flightID IN (SELECT value FROM json_each(?)) ORDER BY b.flightID;";
 
-        flight["origin"]["code"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        flight["destination"]["code"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare getBoardFlights");
+    }
+    sqlite3_bind_text(stmt, 1, list.c_str(), static_cast<int>(list.size()), SQLITE_TRANSIENT);
 
-        flight["origin"]["city"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10));
-        flight["destination"]["city"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 11));
+    flights.reserve(ids.size());
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        readBoardRow(stmt, flights.emplace_back());
+    }
+    return flights;
+}
 
-        flight["origin"]["latitude"] = sqlite3_column_double(stmt, 12);
-        flight["origin"]["longitude"] = sqlite3_column_double(stmt, 13);
-        flight["destination"]["latitude"] = sqlite3_column_double(stmt, 14);
-        flight["destination"]["longitude"] = sqlite3_column_double(stmt, 15);
+FlightChanges Db::getFlightChanges(std::int64_t since, int limit) {
+    static const int series = metrics::dbSeries("getFlightChanges");
+    metrics::DbTimer timer(series);
+    FlightChanges out;
+    out.version = since;
+
+    auto conn = readConn();
+    std::string sql = "SELECT ";
+    sql += kBoardColumns;
+    sql += ", c.version, c.deleted, c.flightID"
+           " FROM FlightChange c LEFT JOIN FlightBoard b ON b.flightID = c.flightID"
+           " WHERE c.version > ? ORDER BY c.version LIMIT ?;";
+
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare getFlightChanges");
+    }
+    sqlite3_bind_int64(stmt, 1, since);
+    sqlite3_bind_int(stmt, 2, limit + 1);   // one extra row tells whether more follow
 
-        i++;
+    int rows = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (++rows > limit) {
+            out.more = true;
+            break;
+        }
+        out.version = sqlite3_column_int64(stmt, 17);
+        if (sqlite3_column_int(stmt, 18)) out.deleted.push_back(sqlite3_column_int(stmt, 19));
+        else readBoardRow(stmt, out.flights.emplace_back());
     }
 
-    sqlite3_finalize(stmt);
-    return flights;
+    if (rows == 0) {
+        auto maxStmt = conn.prepare("SELECT IFNULL(MAX(version), 0) FROM FlightChange;");
+        if (!maxStmt) {
+            throw std::runtime_error("Failed to prepare getFlightChanges");
+        }
+        if (sqlite3_step(maxStmt) == SQLITE_ROW) out.version = sqlite3_column_int64(maxStmt, 0);
+    }
+    return out;
 }
 
-crow::json::wvalue Db::getAllPlanes() {
+std::vector<PlaneRow> Db::getAllPlanes() {
+    static const int series = metrics::dbSeries("getAllPlanes");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
     const char* sql = "SELECT planeID, model, speed, maxSeats FROM Plane ORDER BY model ASC;";
-    sqlite3_stmt* stmt = nullptr;
 
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getAllPlanes");
     }
 
-    // create a JSON list container to hold the result objects
-    crow::json::wvalue arr = crow::json::wvalue::list();
-    int i = 0;
-
+    std::vector<PlaneRow> planes;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue p;
-        p["planeID"] = sqlite3_column_int(stmt, 0);
-        p["model"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        p["speed"] = sqlite3_column_int(stmt, 2);
-        p["maxSeats"] = sqlite3_column_int(stmt, 3);
-        arr[i++] = std::move(p);
+        PlaneRow& p = planes.emplace_back();
+        p.planeID = sqlite3_column_int(stmt, 0);
+        p.model = columnText(stmt, 1);
+        p.speed = sqlite3_column_int(stmt, 2);
+        p.maxSeats = sqlite3_column_int(stmt, 3);
     }
 
-    sqlite3_finalize(stmt);
-    return arr;
+    return planes;
 }
 
 
-// Returns airports with their city name as a Crow JSON list.
-crow::json::wvalue Db::getAllAirports() {
+// Returns airports with their city name.
+std::vector<AirportRow> Db::getAllAirports() {
+    static const int series = metrics::dbSeries("getAllAirports");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
     const char* sql =
         "SELECT a.airportID, a.code, c.name "
         "FROM Airport a JOIN Cities c ON a.cityID = c.cityID "
         "ORDER BY a.code ASC;";
 
-    sqlite3_stmt* stmt = nullptr;
 
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getAllAirports");
     }
 
-    crow::json::wvalue arr = crow::json::wvalue::list();
-    int i = 0;
-
+    std::vector<AirportRow> airports;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue a;
-        a["airportID"] = sqlite3_column_int(stmt, 0);
-        a["code"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        a["city"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        arr[i++] = std::move(a);
+        AirportRow& a = airports.emplace_back();
+        a.airportID = sqlite3_column_int(stmt, 0);
+        a.code = columnText(stmt, 1);
+        a.city = columnText(stmt, 2);
     }
 
-    sqlite3_finalize(stmt);
-    return arr;
+    return airports;
 }
 
 // Return the airlines
-crow::json::wvalue Db::getAllAirlines() {
+std::vector<AirlineRow> Db::getAllAirlines() {
+    static const int series = metrics::dbSeries("getAllAirlines");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
     const char* sql =
         "SELECT airlineID, name, logoPath "
         "FROM Airline ORDER BY name ASC;";
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getAllAirlines");
     }
 
-    crow::json::wvalue arr = crow::json::wvalue::list();
-    int i = 0;
-
+    std::vector<AirlineRow> airlines;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        crow::json::wvalue a;
-        a["airlineID"] = sqlite3_column_int(stmt, 0);
-        a["name"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        a["logoPath"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        arr[i++] = std::move(a);
+        AirlineRow& a = airlines.emplace_back();
+        a.airlineID = sqlite3_column_int(stmt, 0);
+        a.name = columnText(stmt, 1);
+        a.logoPath = columnText(stmt, 2);
     }
 
-    sqlite3_finalize(stmt);
-    return arr;
+    return airlines;
+}
+
+ReferenceIds Db::getReferenceIds() {
+    static const int series = metrics::dbSeries("getReferenceIds");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
+    ReferenceIds ids;
+
+    // each query yields (key, id) rows; the first ID seen for a key wins
+    auto load = [&conn](const char* sql, std::unordered_map<std::string, int>& out) {
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare getReferenceIds");
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            out.emplace(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                        sqlite3_column_int(stmt, 1));
+        }
+    };
+
+    load("SELECT code, airportID FROM Airport ORDER BY airportID;", ids.airportByCode);
+    load("SELECT name, airlineID FROM Airline ORDER BY airlineID;", ids.airlineByName);
+    load("SELECT model, planeID FROM Plane ORDER BY planeID;", ids.planeByModel);
+    return ids;
 }
 
 int Db::createFlight(int planeID, int airlineID,
                      int originAirportID, int destinationAirportID,
                      const std::string& gate,
                      int passengerCount, const std::string& departureTime) {
-    const char* sql =
-        "INSERT INTO Flight(planeID, airlineID, originAirportID, destinationAirportID, gate, passengerCount, departureTime) "
-        "VALUES(?, ?, ?, ?, ?, ?, ?);";
+    static const int series = metrics::dbSeries("createFlight");
+    metrics::DbTimer timer(series);
+    const Departure departure = canonicalDeparture(departureTime);
+    int flightID = 0;
+    runWrite([&](Lease& conn) {
+        const char* sql =
+            "INSERT INTO Flight(planeID, airlineID, originAirportID, destinationAirportID, gate, passengerCount, departureTime, departureEpoch) "
+            "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
+
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare createFlight");
+        }
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare createFlight");
-    }
+        sqlite3_bind_int(stmt, 1, planeID);
+        sqlite3_bind_int(stmt, 2, airlineID);
+        sqlite3_bind_int(stmt, 3, originAirportID);
+        sqlite3_bind_int(stmt, 4, destinationAirportID);
+        sqlite3_bind_text(stmt, 5, gate.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 6, passengerCount);
+        sqlite3_bind_text(stmt, 7, departure.text.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 8, departure.epoch);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to INSERT flight");
+        }
 
-    sqlite3_bind_int(stmt, 1, planeID);
-    sqlite3_bind_int(stmt, 2, airlineID);
-    sqlite3_bind_int(stmt, 3, originAirportID);
-    sqlite3_bind_int(stmt, 4, destinationAirportID);
-    sqlite3_bind_text(stmt, 5, gate.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 6, passengerCount);
-    sqlite3_bind_text(stmt, 7, departureTime.c_str(), -1, SQLITE_TRANSIENT);
+        flightID = static_cast<int>(sqlite3_last_insert_rowid(conn));
+    });
+    return flightID;
+}
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        throw std::runtime_error("Failed to INSERT flight");
-    }
+std::vector<BatchItemResult> Db::createFlights(const std::vector<FlightInput>& flights) {
+    static const int series = metrics::dbSeries("createFlights");
+    metrics::DbTimer timer(series);
+    std::vector<BatchItemResult> results(flights.size());
+    if (flights.empty()) return results;
+
+    // the whole batch is one job, so it shares a single commit
+    runWrite([&](Lease& conn) {
+        const char* sql =
+            "INSERT INTO Flight(planeID, airlineID, originAirportID, destinationAirportID, gate, passengerCount, departureTime, departureEpoch) "
+            "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
+
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare createFlights");
+        }
 
-    sqlite3_finalize(stmt);
-    return static_cast<int>(sqlite3_last_insert_rowid(db_));
+        Departure departure;
+        for (std::size_t i = 0; i < flights.size(); ++i) {
+            const auto& f = flights[i];
+            if (!parseDeparture(f.departureTime, departure)) {
+                results[i].error = "Invalid departureTime: " + f.departureTime;
+                continue;
+            }
+
+            sqlite3_bind_int(stmt, 1, f.planeID);
+            sqlite3_bind_int(stmt, 2, f.airlineID);
+            sqlite3_bind_int(stmt, 3, f.originAirportID);
+            sqlite3_bind_int(stmt, 4, f.destinationAirportID);
+            sqlite3_bind_text(stmt, 5, f.gate.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 6, f.passengerCount);
+            sqlite3_bind_text(stmt, 7, departure.text.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 8, departure.epoch);
+
+            // a constraint failure only rolls back this statement, not the transaction
+            if (sqlite3_step(stmt) == SQLITE_DONE) {
+                results[i].flightID = static_cast<int>(sqlite3_last_insert_rowid(conn));
+            } else {
+                results[i].error = sqlite3_errmsg(conn);
+            }
+            sqlite3_reset(stmt);
+        }
+    });
+    return results;
 }
 
 bool Db::getFlightById(int flightID, crow::json::wvalue& out) {
+    static const int series = metrics::dbSeries("getFlightById");
+    metrics::DbTimer timer(series);
+    auto conn = readConn();
     const char* sql =
         "SELECT flightID, planeID, airlineID, originAirportID, destinationAirportID, "
         "gate, passengerCount, departureTime "
         "FROM Flight WHERE flightID = ?;";
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare getFlightById");
     }
 
@@ -475,7 +1195,6 @@ bool Db::getFlightById(int flightID, crow::json::wvalue& out) {
         out["departureTime"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
     }
 
-    sqlite3_finalize(stmt);
     return found;
 }
 
@@ -487,49 +1206,59 @@ bool Db::updateFlight(int flightID,
                       const std::string& gate,
                       int passengerCount,
                       const std::string& departureTime) {
-    const char* sql =
-        "UPDATE Flight SET planeID=?, airlineID=?, originAirportID=?, destinationAirportID=?, "
-        "gate=?, passengerCount=?, departureTime=? "
-        "WHERE flightID=?;";
-
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare updateFlight");
-    }
-
-    sqlite3_bind_int(stmt, 1, planeID);
-    sqlite3_bind_int(stmt, 2, airlineID);
-    sqlite3_bind_int(stmt, 3, originAirportID);
-    sqlite3_bind_int(stmt, 4, destinationAirportID);
-    sqlite3_bind_text(stmt, 5, gate.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 6, passengerCount);
-    sqlite3_bind_text(stmt, 7, departureTime.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 8, flightID);
+    static const int series = metrics::dbSeries("updateFlight");
+    metrics::DbTimer timer(series);
+    const Departure departure = canonicalDeparture(departureTime);
+    bool changed = false;
+    runWrite([&](Lease& conn) {
+        const char* sql =
+            "UPDATE Flight SET planeID=?, airlineID=?, originAirportID=?, destinationAirportID=?, "
+            "gate=?, passengerCount=?, departureTime=?, departureEpoch=? "
+            "WHERE flightID=?;";
+
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare updateFlight");
+        }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        throw std::runtime_error("Failed to UPDATE flight");
-    }
+        sqlite3_bind_int(stmt, 1, planeID);
+        sqlite3_bind_int(stmt, 2, airlineID);
+        sqlite3_bind_int(stmt, 3, originAirportID);
+        sqlite3_bind_int(stmt, 4, destinationAirportID);
+        sqlite3_bind_text(stmt, 5, gate.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 6, passengerCount);
+        sqlite3_bind_text(stmt, 7, departure.text.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 8, departure.epoch);
+        sqlite3_bind_int(stmt, 9, flightID);
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to UPDATE flight");
+        }
 
-    sqlite3_finalize(stmt);
-    return sqlite3_changes(db_) > 0;
+        changed = sqlite3_changes(conn) > 0;
+    });
+    return changed;
 }
 
 bool Db::deleteFlight(int flightID) {
-    const char* sql = "DELETE FROM Flight WHERE flightID = ?;";
-
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare deleteFlight");
-    }
+    static const int series = metrics::dbSeries("deleteFlight");
+    metrics::DbTimer timer(series);
+    bool changed = false;
+    runWrite([&](Lease& conn) {
+        const char* sql = "DELETE FROM Flight WHERE flightID = ?;";
+
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare deleteFlight");
+        }
 
-    sqlite3_bind_int(stmt, 1, flightID);
+        sqlite3_bind_int(stmt, 1, flightID);
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        throw std::runtime_error("Failed to DELETE flight");
-    }
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to DELETE flight");
+        }
 
-    sqlite3_finalize(stmt);
-    return sqlite3_changes(db_) > 0;
-}
\ No newline at end of file
+        changed = sqlite3_changes(conn) > 0;
+    });
+    return changed;
+}
@@ -10,26 +10,288 @@
  */
 
 #include <sqlite3.h>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "crow_all.h"
+#include "slowquerylog.h"
+
+/**
+ * @brief SQLite durability/performance presets.
+ *
+ * - Durable: synchronous=FULL, small cache, no mmap (SQLite defaults, WAL).
+ * - Balanced: synchronous=NORMAL (a power cut may lose the last commits,
+ *   never corrupts), larger cache, 256 MB mmap.
+ * - Fast: synchronous=OFF, big cache and 1 GB mmap; for bulk loads and
+ *   throwaway boards where losing recent writes on a crash is acceptable.
+ */
+enum class DbProfile { Durable, Balanced, Fast };
+
+/**
+ * @brief Parses a profile name ("durable", "balanced", "fast").
+ * @return True if the name is recognised.
+ */
+bool parseDbProfile(const std::string& name, DbProfile& out);
+
+/** @brief Returns the name of a profile. */
+const char* dbProfileName(DbProfile profile);
+
+/**
+ * @brief In-memory flight model used to enrich API responses.
+ *
+ * Filled straight from FlightBoard rows by Db::getFlightsPage; the
+ * list handler then computes status, distance, duration, and arrival time.
+ */
+struct FlightItem {
+    int flightID;
+    std::string airlineName;
+    std::string airlineLogoPath;
+    std::string plane;
+    int planeSpeed =0;
+    std::string arrivalTime;
+    double distanceKm =0.0;
+    int durationMinutes = 0;
+    std::string gate;
+    int passengers;
+    std::string departureTime;
+    std::int64_t departureEpoch = 0;   // departureTime as UTC seconds (FlightBoard.departureEpoch)
+    bool hasDepartureEpoch = true;     // false for legacy rows whose departureTime never parsed (NULL epoch)
+    const char* statusClass = "";   // static strings, set by the list handler
+    const char* statusText = "";
+    double progress = 0.0;
+    
+    struct Airport {
+        std::string city;
+        std::string code;
+        double latitude;
+        double longitude;
+    } origin, destination;
+};
+
+/** @brief Plane row as listed by GET /api/planes. */
+struct PlaneRow {
+    int planeID = 0;
+    std::string model;
+    int speed = 0;
+    int maxSeats = 0;
+};
+
+/** @brief Airport row (with its city name) as listed by GET /api/airports. */
+struct AirportRow {
+    int airportID = 0;
+    std::string code;
+    std::string city;
+};
+
+/** @brief Airline row as listed by GET /api/airlines. */
+struct AirlineRow {
+    int airlineID = 0;
+    std::string name;
+    std::string logoPath;
+};
+
+/** @brief Board status of a flight; the values are also the status sort order. */
+enum class FlightStatus { Boarding = 0, OnTime = 1, Departed = 2 };
+
+/** @brief Number of FlightStatus values (segments of the status sort). */
+constexpr int kStatusSegments = 3;
+
+/** @brief Boarding opens this long before departure. */
+constexpr std::int64_t kBoardingSeconds = 30 * 60;
+
+/**
+ * @brief Status of a flight at a given time.
+ * @param departure Departure time, UTC seconds since the epoch.
+ * @param now Current time, UTC seconds since the epoch.
+ */
+inline FlightStatus statusAt(std::int64_t departure, std::int64_t now) {
+    if (departure < now) return FlightStatus::Departed;
+    if (departure - now < kBoardingSeconds) return FlightStatus::Boarding;
+    return FlightStatus::OnTime;
+}
+
+/**
+ * @brief Half-open departure window [from, to) in UTC epoch seconds.
+ *
+ * Either end may be left unset (open). Filters FlightBoard.departureEpoch,
+ * so any window is an index range scan.
+ */
+struct TimeWindow {
+    std::optional<std::int64_t> from;
+    std::optional<std::int64_t> to;
+
+    bool empty() const { return !from && !to; }
+};
+
+/**
+ * @brief Keyset position for flight pagination.
+ *
+ * Holds the sort key (departureEpoch in decimal, or gate) and flightID of the last row
+ * already returned; the next page starts strictly after it. Status-sorted
+ * cursors also record which FlightStatus segment that row was in.
+ */
+struct FlightCursor {
+    std::string key;
+    int flightID = 0;
+    int segment = 0;   ///< sort=status only: FlightStatus of the last row
+};
+
+/**
+ * @brief Raw Flight table fields for one flight being inserted.
+ */
+struct FlightInput {
+    int planeID = 0;
+    int airlineID = 0;
+    int originAirportID = 0;
+    int destinationAirportID = 0;
+    std::string gate;
+    int passengerCount = 0;
+    std::string departureTime;
+};
+
+/**
+ * @brief Outcome of one item in a batch insert.
+ *
+ * flightID is set on success; otherwise error says why the row was rejected.
+ */
+struct BatchItemResult {
+    int flightID = 0;
+    std::string error;
+};
+
+/**
+ * @brief Flights changed after a change-log version (GET /api/flights/changes).
+ */
+struct FlightChanges {
+    std::vector<FlightItem> flights;   ///< created or updated, in change order
+    std::vector<int> deleted;          ///< tombstones, in change order
+    std::int64_t version = 0;          ///< pass as `since` to continue from here
+    bool more = false;                 ///< the limit cut the list short
+};
+
+/**
+ * @brief Name -> ID lookups for the reference tables.
+ *
+ * Used by bulk import to resolve human-readable schedule columns
+ * without a query per row.
+ */
+struct ReferenceIds {
+    std::unordered_map<std::string, int> airportByCode;
+    std::unordered_map<std::string, int> airlineByName;
+    std::unordered_map<std::string, int> planeByModel;
+};
 
 /**
  * @brief SQLite database wrapper for Flight Logger.
  *
  * Handles schema setup, seed data, queries, pagination, and flight CRUD.
+ *
+ * Owns a small connection pool: one writer connection (serialized by a
+ * mutex) and N read-only connections. The database runs in WAL mode so
+ * readers never block each other or the writer. Each call leases a
+ * connection for its duration and hands it back when done.
+ *
+ * Flight mutations don't touch the writer directly: they are queued for a
+ * dedicated writer thread that group-commits everything pending in one
+ * transaction, and each caller returns once its batch has committed.
  */
 class Db {
 public:
     /**
      * @brief Opens or creates the database file.
      * @param path Path to the SQLite file.
-     */    
-explicit Db(const std::string& path);
+     * @param readerCount Number of read-only connections in the pool (min 1).
+     * @param flushIntervalMs How long the writer waits for more mutations to
+     *        join a group commit (0 = commit whatever is already queued).
+     * @param profile PRAGMA preset applied to every connection as it opens.
+     */
+    explicit Db(const std::string& path, int readerCount = 4, int flushIntervalMs = 2,
+                DbProfile profile = DbProfile::Durable);
     /**
-     * @brief Closes the database connection.
+     * @brief Drains the write queue and closes every pooled connection.
      */
     ~Db();
 
+    Db(const Db&) = delete;
+    Db& operator=(const Db&) = delete;
+
+    /** @brief PRAGMA profile the connections were opened with. */
+    DbProfile profile() const { return profile_; }
+
+    /** @brief Number of read-only connections in the pool. */
+    int readerCount() const { return static_cast<int>(readers_.size()); }
+
+    /** @brief Prepared statement cache counters (summed over all connections). */
+    struct StatementCacheStats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
+
+    /** @brief Returns statement cache hit/miss counts since startup. */
+    StatementCacheStats statementCacheStats() const;
+
+    /**
+     * @brief Aggregate cost of one SQL statement shape since startup.
+     *
+     * Whitespace is collapsed and literals replaced by '?', so every
+     * search/window/sort variant of a dynamic query is its own entry.
+     * Statements SQLite runs on its own behalf (FTS5 shadow tables) are
+     * listed too; their time is also part of the statement that ran them.
+     */
+    struct SqlStatementStats {
+        std::string sql;                  ///< normalized statement text
+        std::uint64_t calls = 0;          ///< completed runs (step to done, or reset)
+        std::uint64_t totalNs = 0;
+        std::uint64_t maxNs = 0;
+        std::uint64_t rows = 0;           ///< result rows stepped
+        std::uint64_t vmSteps = 0;        ///< SQLITE_STMTSTATUS_VM_STEP
+        std::uint64_t fullScanSteps = 0;  ///< SQLITE_STMTSTATUS_FULLSCAN_STEP (table scans without an index)
+    };
+
+    /**
+     * @brief Per-statement profile collected on every pooled connection.
+     * @return One entry per normalized statement, highest total time first.
+     */
+    std::vector<SqlStatementStats> sqlStats() const;
+
+    /**
+     * @brief Reports statements at least log->threshold() slow to log.
+     * @param log Must outlive the Db (or be unset first); null stops logging.
+     */
+    void setSlowQueryLog(SlowQueryLog* log) { slowQueryLog_.store(log, std::memory_order_release); }
+
+    /**
+     * @brief Version of the data, bumped after every committed write.
+     *
+     * Writes through this Db bump it as they commit. Commits by anything
+     * else on the same file (`server --import` in another process, the
+     * sqlite3 shell) are noticed here: each call checks PRAGMA data_version,
+     * which is a cheap read of the WAL header.
+     *
+     * Anything derived from query results (cached counts, responses) is
+     * still valid as long as this value hasn't changed.
+     */
+    std::uint64_t dataVersion();
+
+    /**
+     * @brief High-water mark of the FlightChange log (0 when it is empty).
+     *
+     * Unlike dataVersion() it is stored in the database, so it also counts
+     * changes made by other processes and survives restarts.
+     */
+    std::int64_t changeVersion();
+
 
     /**
      * @brief Runs the schema SQL file.
@@ -47,50 +309,104 @@ explicit Db(const std::string& path);
     /** @brief Returns all flights (joined with related tables). */
     crow::json::wvalue getAllFlights();
 
-    /** @brief Returns all planes. */
-    crow::json::wvalue getAllPlanes();
+    /** @brief Returns all planes, ordered by model. */
+    std::vector<PlaneRow> getAllPlanes();
+
+    /** @brief Returns all airports, ordered by code. */
+    std::vector<AirportRow> getAllAirports();
 
-    /** @brief Returns all airports. */
-    crow::json::wvalue getAllAirports();
+    /** @brief Returns all airlines, ordered by name. */
+    std::vector<AirlineRow> getAllAirlines();
 
-    /** @brief Returns all airlines. */
-    crow::json::wvalue getAllAirlines();
+    /** @brief Loads airport code, airline name and plane model -> ID maps. */
+    ReferenceIds getReferenceIds();
 
     /**
      * @brief Returns one page of flights with optional filters.
+     * @return Flights in sort order, without the derived fields
+     *         (status, distance, duration, arrival time).
      * @param limit Max rows to return.
      * @param offset Rows to skip.
-     * @param sort Sort key ("departure" or "gate").
+     * @param sort Sort key ("departure", "gate" or "status"). Status order
+     *        is boarding, on time, then departed, each by departure time;
+     *        it is read as three departure-index range scans.
      * @param search Optional search string (empty for none).
-     * @param date Optional date filter (empty for none).
+     * @param window Departure window (empty for none).
+     * @param now Reference time for the status segments, UTC epoch seconds
+     *        (ignored for other sorts).
+     * @param total Set to the number of flights matching search/window
+     *        (ignoring paging), served from the count cache when possible.
+     * @param after Optional keyset cursor; when set, rows are read from the
+     *        sort index starting after it and offset should be 0.
      */
-    crow::json::wvalue getFlightsPage(int limit, int offset,
+    std::vector<FlightItem> getFlightsPage(int limit, int offset,
                                   const std::string& sort,
                                   const std::string& search,
-                                  const std::string& date);
+                                  const TimeWindow& window,
+                                  std::int64_t now,
+                                  int& total,
+                                  const std::optional<FlightCursor>& after = std::nullopt);
+
+
+    /**
+     * @brief Returns the board rows of the given flights, in flightID order.
+     * @param ids Flight IDs; IDs with no flight (deleted) are skipped.
+     * @return Flights without the derived fields.
+     */
+    std::vector<FlightItem> getBoardFlights(const std::vector<int>& ids);
 
+    /**
+     * @brief Reads the change log after a version.
+     *
+     * Each flight appears once, at its latest change. When nothing changed,
+     * version is the log's current high-water mark, which is below since
+     * if the database was reset (clients should then start over from 0).
+     *
+     * @param since Last version the caller has seen (0 for everything).
+     * @param limit Max flights + tombstones to return.
+     */
+    FlightChanges getFlightChanges(std::int64_t since, int limit);
 
     /**
      * @brief Returns total flights matching filters.
+     *
+     * Counts are cached per (search, window) and invalidated by dataVersion().
+     *
      * @param search Optional search string.
-     * @param date Optional date filter.
+     * @param window Departure window (empty for none).
      * @return Total matching rows.
      */
     int getFlightsCount(const std::string& search,
-                    const std::string& date);
+                    const TimeWindow& window);
 
     
     /**
      * @brief Inserts a new flight.
+     *
+     * departureTime may be any form timeutil::parseDateTime accepts; it is
+     * stored as "YYYY-MM-DDTHH:MM:SS".
+     *
      * @return New flightID.
+     * @throws std::invalid_argument if departureTime does not parse.
      */
     int createFlight(int planeID, int airlineID,
                      int originAirportID, int destinationAirportID,
                      const std::string& gate,
                      int passengerCount, const std::string& departureTime);
 
-    
-                     
+
+    /**
+     * @brief Inserts many flights in a single transaction.
+     *
+     * Uses one prepared INSERT for every row and one commit for the whole
+     * batch. A row that violates a constraint or has an unparsable
+     * departureTime is skipped and reported; the rest of the batch still
+     * commits.
+     *
+     * @param flights Rows to insert.
+     * @return One result per input row, in order.
+     */
+    std::vector<BatchItemResult> createFlights(const std::vector<FlightInput>& flights);
 
     /**
      * @brief Gets a flight by ID (raw Flight table fields).
@@ -101,8 +417,9 @@ explicit Db(const std::string& path);
     bool getFlightById(int flightID, crow::json::wvalue& out);
 
     /**
-     * @brief Updates a flight.
+     * @brief Updates a flight (departureTime is normalized as in createFlight).
      * @return True if a row was updated.
+     * @throws std::invalid_argument if departureTime does not parse.
      */
     bool updateFlight(int flightID,
                       int planeID,
@@ -122,7 +439,183 @@ explicit Db(const std::string& path);
     bool deleteFlight(int flightID);
 
 private:
-    sqlite3* db_{nullptr};
+    /**
+     * @brief One pooled connection plus its prepared statement cache.
+     *
+     * Statements are keyed by their full SQL text, so each dynamic
+     * search/date/sort variant gets its own cached entry.
+     */
+    struct Conn {
+        sqlite3* handle{nullptr};
+        Db* owner{nullptr};
+        std::unordered_map<std::string, sqlite3_stmt*> stmts;
+
+        /** @brief A statement between its first step and its profile event. */
+        struct Running {
+            std::chrono::steady_clock::time_point start;
+            std::uint64_t rows = 0;
+        };
+        std::unordered_map<sqlite3_stmt*, Running> running;   // only touched by the lease holder
+
+        /** @brief Profile by raw statement text; normalized when read (sqlStats()). */
+        std::unordered_map<std::string, SqlStatementStats> sqlStats;
+        mutable std::mutex sqlStatsMutex;   // trace callback vs. sqlStats()
+    };
+
+    /**
+     * @brief RAII handle on a prepared statement.
+     *
+     * Cached statements are reset and their bindings cleared when the
+     * handle goes out of scope; uncached ones are finalized.
+     */
+    class Stmt {
+    public:
+        Stmt(sqlite3_stmt* stmt, bool cached) : stmt_(stmt), cached_(cached) {}
+        ~Stmt();
+        Stmt(Stmt&& other) noexcept : stmt_(other.stmt_), cached_(other.cached_) { other.stmt_ = nullptr; }
+        Stmt(const Stmt&) = delete;
+        Stmt& operator=(const Stmt&) = delete;
+        Stmt& operator=(Stmt&&) = delete;
+
+        explicit operator bool() const { return stmt_ != nullptr; }
+        operator sqlite3_stmt*() const { return stmt_; }
+
+    private:
+        sqlite3_stmt* stmt_;
+        bool cached_;
+    };
+
+    /**
+     * @brief RAII lease on a pooled connection.
+     *
+     * A writer lease holds the writer mutex; a reader lease returns its
+     * connection to the idle list when it goes out of scope.
+     */
+    class Lease {
+    public:
+        Lease(Db& owner, Conn* conn, std::unique_lock<std::mutex> writerLock);
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        sqlite3* get() const { return conn_->handle; }
+        operator sqlite3*() const { return conn_->handle; }
+
+        /**
+         * @brief Returns a cached statement for sql, preparing it on first use.
+         * @return Statement handle; evaluates false if preparation failed.
+         */
+        Stmt prepare(const std::string& sql);
+
+    private:
+        Db* owner_;
+        Conn* conn_;
+        std::unique_lock<std::mutex> writerLock_;
+    };
+
+    /** @brief Upper bound on cached statements per connection. */
+    static constexpr std::size_t kMaxCachedStatements = 64;
+
+    /** @brief Upper bound on distinct statement texts profiled per connection. */
+    static constexpr std::size_t kMaxProfiledStatements = 512;
+
+    DbProfile profile_;
+
+    Conn writer_;
+    std::mutex writerMutex_;
+
+    std::vector<std::unique_ptr<Conn>> readers_;
+    std::vector<Conn*> idleReaders_;
+    std::mutex poolMutex_;
+    std::condition_variable poolCv_;
+
+    std::atomic<SlowQueryLog*> slowQueryLog_{nullptr};
+
+    std::atomic<std::uint64_t> stmtCacheHits_{0};
+    std::atomic<std::uint64_t> stmtCacheMisses_{0};
+
+    /** @brief A cached COUNT(*) and the dataVersion it was taken at. */
+    struct CachedCount {
+        std::uint64_t version;
+        int count;
+    };
+
+    /** @brief Upper bound on cached (search, window) counts before the cache is dropped. */
+    static constexpr std::size_t kMaxCachedCounts = 256;
+
+    std::atomic<std::uint64_t> dataVersion_{0};
+
+    // PRAGMA data_version values only compare on one connection, so it
+    // gets its own (not pooled, not traced)
+    sqlite3* versionConn_ = nullptr;
+    sqlite3_stmt* versionStmt_ = nullptr;
+    std::int64_t seenDataVersion_ = 0;
+    std::mutex versionMutex_;
+
+    std::unordered_map<std::string, CachedCount> countCache_;
+    std::mutex countCacheMutex_;
+
+    /** @brief One queued mutation and the promise its caller waits on. */
+    struct WriteJob {
+        std::function<void(Lease&)> work;
+        std::promise<void> done;
+    };
+
+    /** @brief Most jobs folded into a single group commit. */
+    static constexpr std::size_t kMaxWriteBatch = 512;
+
+    std::deque<WriteJob> writeQueue_;
+    std::mutex writeQueueMutex_;
+    std::condition_variable writeQueueCv_;
+    bool stopWriter_ = false;
+    std::chrono::milliseconds flushInterval_;
+    std::thread writerThread_;
+
+    /**
+     * @brief Queues a mutation for the writer thread and waits for its commit.
+     * @param work Runs on the writer connection inside the group transaction;
+     *        throwing rolls back just this job and rethrows in the caller.
+     */
+    void runWrite(std::function<void(Lease&)> work);
+
+    /** @brief Writer thread: collects queued jobs and commits them in batches. */
+    void writerLoop();
+
+    /** @brief Runs one batch in a single transaction, a savepoint per job. */
+    void commitBatch(std::vector<WriteJob>& batch);
+
+    /** @brief Marks every cached result stale; call after a write commits. */
+    void bumpDataVersion() { dataVersion_.fetch_add(1, std::memory_order_acq_rel); }
+
+    /** @brief Counts flights matching filters on conn, using the count cache. */
+    int countFlights(Lease& conn, const std::string& search, const TimeWindow& window);
+
+    /** @brief Adds a column to an existing table if it lacks it (schema upgrades). */
+    void addColumnIfMissing(const std::string& table, const std::string& column, const std::string& type);
+
+    /** @brief Leases the writer connection (blocks while another write runs). */
+    Lease writeConn();
+
+    /** @brief Leases an idle reader connection (blocks while all are busy). */
+    Lease readConn();
+
+    /** @brief Returns a reader connection to the idle list. */
+    void releaseReader(Conn* conn);
+
+    /** @brief Finalizes cached statements and closes a connection. */
+    static void closeConn(Conn& conn);
+
+    /**
+     * @brief sqlite3_trace_v2 callback (ctx is the Conn): times each
+     * statement, counts its rows and folds them into Conn::sqlStats;
+     * slow ones also go to the slow-query log.
+     */
+    static int traceStatement(unsigned type, void* ctx, void* p, void* x);
+
+    /** @brief Registers traceStatement on a freshly opened connection. */
+    void traceConn(Conn& conn);
 
     /** @brief Returns COUNT(*) for a table. */
     int getTableCount(const std::string& tableName);
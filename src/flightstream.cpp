@@ -0,0 +1,307 @@
+/**
+ * @file flightstream.cpp
+ * @brief Implementation of the live departure board stream.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "flightstream.h"
+#include "jsonwriter.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+static std::int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string resyncMessage(std::uint64_t seq) {
+    return R"({"type":"resync","seq":)" + std::to_string(seq) + "}";
+}
+
+FlightStream::FlightStream(Db& db, Options options)
+    : db_(db), options_(options), broadcaster_([this] { broadcastLoop(); }) {}
+
+FlightStream::~FlightStream() {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        stop_ = true;
+    }
+    pendingCv_.notify_one();
+    broadcaster_.join();
+}
+
+void FlightStream::subscribe(crow::websocket::connection& conn) {
+    // The subscriber is registered before the snapshot is read, but the
+    // read runs without the lock so it never stalls the broadcaster, acks or
+    // other subscribes. Broadcasts after seq are held until the snapshot is
+    // queued and follow it; the snapshot already has everything up to seq
+    // (and maybe some of what follows, which the client simply applies twice).
+    std::uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(subscribersMutex_);
+        subscribers_[&conn].snapshotPending = true;
+        seq = seq_.load();
+    }
+
+    std::string snapshot;
+    try {
+        const std::int64_t nowMs = nowMillis();
+        int total = 0;
+        auto flights = db_.getFlightsPage(options_.snapshotSize, 0, "status", "", TimeWindow{}, nowMs / 1000, total);
+
+        JsonWriter out(64 + flights.size() * kFlightJsonBytes);
+        out.beginObject();
+        out.key("type");  out.value("snapshot");
+        out.key("seq");   out.value(seq);
+        out.key("total"); out.value(total);
+        out.key("flights");
+        out.beginArray();
+        for (auto& f : flights) {
+            fillDerivedFields(f, nowMs);
+            writeJson(out, f);
+        }
+        out.endArray();
+        out.endObject();
+        snapshot = out.take();
+    } catch (const std::exception& e) {
+        std::cerr << "flight stream snapshot failed: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(subscribersMutex_);
+        // unless it closed meanwhile (and the connection may be gone)
+        if (subscribers_.erase(&conn) > 0) {
+            conn.close("snapshot failed", crow::websocket::CloseStatusCode::UnexpectedCondition);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    auto it = subscribers_.find(&conn);
+    if (it == subscribers_.end()) return;   // closed while the snapshot was read
+    Subscriber& subscriber = it->second;
+    subscriber.snapshotPending = false;
+    send(conn, subscriber, seq, snapshot);
+
+    auto held = std::move(subscriber.held);
+    for (const auto& [heldSeq, message] : held) send(conn, subscriber, heldSeq, message);
+}
+
+void FlightStream::unsubscribe(crow::websocket::connection& conn) {
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    subscribers_.erase(&conn);
+}
+
+void FlightStream::received(crow::websocket::connection& conn, const std::string& message) {
+    std::uint64_t seq;
+    try {
+        auto json = crow::json::load(message);
+        if (!json || json.t() != crow::json::type::Object || !json.has("type") || !json.has("seq")) return;
+        if (json["type"].s() != "ack") return;
+        seq = static_cast<std::uint64_t>(json["seq"].i());
+    } catch (const std::exception&) {
+        return;   // wrongly typed fields
+    }
+
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    auto it = subscribers_.find(&conn);
+    if (it == subscribers_.end()) return;
+    Subscriber& subscriber = it->second;
+
+    while (!subscriber.unacked.empty() && subscriber.unacked.front().first <= seq) {
+        subscriber.pendingBytes -= subscriber.unacked.front().second;
+        subscriber.unacked.pop_front();
+    }
+    if (!subscriber.lagging || !subscriber.unacked.empty()) return;
+
+    // The resync has been handled. Changes skipped after it was sent may
+    // have missed the client's reload, so those need another round.
+    subscriber.lagging = false;
+    if (subscriber.missed) {
+        subscriber.missed = false;
+        const std::string resync = resyncMessage(seq_.load());
+        subscriber.lagging = true;
+        subscriber.unacked.emplace_back(seq_.load(), resync.size());
+        subscriber.pendingBytes += resync.size();
+        conn.send_text(resync);
+        lagResyncs_++;
+    }
+}
+
+void FlightStream::flightChanged(int flightID) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    if (resync_) return;
+    deleted_.erase(flightID);
+    changed_.insert(flightID);
+    // past the message limit the IDs are useless: drop them, keep the flag
+    if (changed_.size() + deleted_.size() > options_.maxChanges) resync_ = true;
+}
+
+void FlightStream::flightDeleted(int flightID) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    if (resync_) return;
+    changed_.erase(flightID);
+    deleted_.insert(flightID);
+    if (changed_.size() + deleted_.size() > options_.maxChanges) resync_ = true;
+}
+
+void FlightStream::resync() {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    resync_ = true;
+}
+
+FlightStream::Stats FlightStream::stats() const {
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    std::size_t lagging = 0;
+    for (const auto& entry : subscribers_) {
+        if (entry.second.lagging) ++lagging;
+    }
+    return Stats{subscribers_.size(), messages_.load(), resyncs_.load(), lagging, lagResyncs_.load()};
+}
+
+void FlightStream::broadcast(std::uint64_t seq, const std::string& message) {
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    // published under the lock: subscribers registered before this get the message (held
+    // if their snapshot is still being read), later ones start their snapshot at seq
+    seq_.store(seq);
+    for (auto& [conn, subscriber] : subscribers_) send(*conn, subscriber, seq, message);
+    messages_++;
+}
+
+void FlightStream::send(crow::websocket::connection& conn, Subscriber& subscriber,
+                        std::uint64_t seq, const std::string& message) {
+    if (subscriber.snapshotPending) {
+        subscriber.held.emplace_back(seq, message);
+        return;
+    }
+    if (subscriber.lagging) {
+        subscriber.missed = true;
+        return;
+    }
+
+    // a single message bigger than the cap still goes to a subscriber that is caught up
+    std::string lagResync;
+    const std::string* frame = &message;
+    if (subscriber.pendingBytes > 0 && subscriber.pendingBytes + message.size() > options_.maxPendingBytes) {
+        lagResync = resyncMessage(seq);
+        frame = &lagResync;
+        subscriber.lagging = true;
+        subscriber.missed = false;
+        lagResyncs_++;
+    }
+
+    // send_text only queues the frame on the connection's own io thread
+    subscriber.unacked.emplace_back(seq, frame->size());
+    subscriber.pendingBytes += frame->size();
+    conn.send_text(*frame);
+}
+
+void FlightStream::broadcastLoop() {
+    std::int64_t lastTick = nowMillis() / 1000;
+    std::uint64_t lastDataVersion = 0;
+    std::int64_t lastChange = 0;
+    try {
+        lastDataVersion = db_.dataVersion();
+        lastChange = db_.changeVersion();
+    } catch (const std::exception& e) {
+        std::cerr << "flight stream change log unavailable: " << e.what() << std::endl;
+    }
+
+    std::unique_lock<std::mutex> lock(pendingMutex_);
+    while (!stop_) {
+        pendingCv_.wait_for(lock, std::chrono::milliseconds(options_.flushMs), [this] { return stop_; });
+        if (stop_) break;
+
+        std::unordered_set<int> changed;
+        std::unordered_set<int> deleted;
+        changed.swap(changed_);
+        deleted.swap(deleted_);
+        bool resync = resync_;
+        resync_ = false;
+        lock.unlock();
+
+        try {
+            const std::int64_t nowMs = nowMillis();
+            const std::int64_t now = nowMs / 1000;
+            const std::uint64_t seq = seq_.load() + 1;
+
+            // Writes by other processes (server --import) never call
+            // flightChanged(): when the data version moves, the change log
+            // says which flights changed. In-process writes show up here too
+            // and are simply recorded twice.
+            const std::uint64_t dataVersion = db_.dataVersion();
+            if (dataVersion != lastDataVersion) {
+                auto log = db_.getFlightChanges(lastChange, static_cast<int>(options_.maxChanges));
+                if (log.more || log.version < lastChange) {
+                    // too many to list, or the database was replaced
+                    resync = true;
+                    lastChange = db_.changeVersion();
+                } else {
+                    for (const auto& f : log.flights) changed.insert(f.flightID);
+                    for (int id : log.deleted) {
+                        changed.erase(id);
+                        deleted.insert(id);
+                    }
+                    lastChange = log.version;
+                }
+                lastDataVersion = dataVersion;
+            }
+
+            // Status flips since the last tick: departure passed (boarding ->
+            // departed) or boarding opened (departure - kBoardingSeconds passed).
+            // statusAt(d, t) flips when d < t + lead first holds, so the flights
+            // that flipped between the ticks are exactly [lastTick + lead, now + lead).
+            if (now - lastTick >= options_.statusTickSeconds) {
+                for (std::int64_t lead : {std::int64_t{0}, kBoardingSeconds}) {
+                    TimeWindow flips;
+                    flips.from = lastTick + lead;
+                    flips.to = now + lead;
+                    int total = 0;
+                    auto rows = db_.getFlightsPage(static_cast<int>(options_.maxChanges) + 1, 0, "departure", "",
+                                                   flips, now, total);
+                    for (const auto& f : rows) changed.insert(f.flightID);
+                }
+                lastTick = now;
+            }
+
+            bool idle;
+            {
+                std::lock_guard<std::mutex> subscribersLock(subscribersMutex_);
+                idle = subscribers_.empty();
+            }
+
+            if (!idle && changed.size() + deleted.size() > options_.maxChanges) resync = true;
+
+            if (!idle && resync) {
+                broadcast(seq, resyncMessage(seq));
+                resyncs_++;
+            } else if (!idle && (!changed.empty() || !deleted.empty())) {
+                auto flights = db_.getBoardFlights(std::vector<int>(changed.begin(), changed.end()));
+
+                // deleted between being recorded and read back
+                for (const auto& f : flights) changed.erase(f.flightID);
+                for (int id : changed) deleted.insert(id);
+
+                JsonWriter out(64 + flights.size() * kFlightJsonBytes + deleted.size() * 12);
+                out.beginObject();
+                out.key("type"); out.value("changes");
+                out.key("seq");  out.value(seq);
+                out.key("flights");
+                out.beginArray();
+                for (auto& f : flights) {
+                    fillDerivedFields(f, nowMs);
+                    writeJson(out, f);
+                }
+                out.endArray();
+                out.key("deleted");
+                out.beginArray();
+                for (int id : deleted) out.value(id);
+                out.endArray();
+                out.endObject();
+                broadcast(seq, out.str());
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "flight stream broadcast failed: " << e.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
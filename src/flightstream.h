@@ -0,0 +1,134 @@
+#pragma once
+
+/**
+ * @file flightstream.h
+ * @brief Live departure board updates over WebSocket.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Subscribers get a snapshot of the board when they connect and then
+ * only the flights that changed: writes reported by the API handlers,
+ * writes by other processes found in the FlightChange log, and status
+ * flips (boarding opens, departure) found by a timer.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "crow_all.h"
+#include "db.h"
+
+/**
+ * @brief Fan-out of flight changes to WebSocket subscribers.
+ *
+ * Changes are coalesced: handlers only record flight IDs, and a single
+ * thread turns everything recorded during one flush interval into one
+ * message that every subscriber receives. A flight edited ten times in
+ * that interval is sent once, and idle subscribers cost nothing but their
+ * socket. When more flights changed than fit in one message (an import,
+ * a large batch), subscribers are told to reload the board instead.
+ *
+ * Memory per subscriber is bounded by flow control: every message has a
+ * "seq" and clients answer {"type":"ack","seq":N} once they have handled
+ * it. A subscriber with more than maxPendingBytes unacknowledged gets one
+ * resync and nothing else until it acknowledges that, so a client that
+ * stops reading never grows its connection's write queue past the cap.
+ *
+ * Messages are JSON objects with a "type" and a "seq":
+ * - "snapshot": {"type", "seq", "total", "flights": [...]} on connect (first board page, status order)
+ * - "changes":  {"type", "seq", "flights": [...], "deleted": [ids]}
+ * - "resync":   {"type", "seq"}; fetch /api/flights again
+ */
+class FlightStream {
+public:
+    /** @brief Tuning knobs. */
+    struct Options {
+        int flushMs = 250;                 ///< coalescing interval
+        int statusTickSeconds = 5;         ///< how often status flips are looked for
+        std::size_t maxChanges = 500;      ///< more changed flights than this become a resync
+        int snapshotSize = 100;            ///< flights in the snapshot (one board page)
+        std::size_t maxPendingBytes = 256 * 1024;   ///< unacknowledged bytes before a subscriber is resynced
+    };
+
+    /** @brief Counters reported by /admin/stream-stats. */
+    struct Stats {
+        std::size_t subscribers;
+        std::uint64_t messages;   ///< change/resync messages broadcast
+        std::uint64_t resyncs;
+        std::size_t lagging;      ///< subscribers currently held back for not acknowledging
+        std::uint64_t lagResyncs; ///< resyncs sent to single subscribers that fell behind
+    };
+
+    FlightStream(Db& db, Options options);
+
+    /** @brief Stops the broadcaster thread. */
+    ~FlightStream();
+
+    FlightStream(const FlightStream&) = delete;
+    FlightStream& operator=(const FlightStream&) = delete;
+
+    /** @brief Adds a subscriber and sends it the snapshot. */
+    void subscribe(crow::websocket::connection& conn);
+
+    /** @brief Removes a subscriber (connection closed or failed). */
+    void unsubscribe(crow::websocket::connection& conn);
+
+    /**
+     * @brief Handles a message from a subscriber: {"type":"ack","seq":N}
+     * releases every message up to N. Anything else is ignored.
+     */
+    void received(crow::websocket::connection& conn, const std::string& message);
+
+    /** @brief Records a created or updated flight. */
+    void flightChanged(int flightID);
+
+    /** @brief Records a deleted flight. */
+    void flightDeleted(int flightID);
+
+    /** @brief Tells subscribers to reload instead of sending individual changes. */
+    void resync();
+
+    Stats stats() const;
+
+private:
+    Db& db_;
+    const Options options_;
+
+    /** @brief Flow-control state of one connection. */
+    struct Subscriber {
+        std::deque<std::pair<std::uint64_t, std::size_t>> unacked;   ///< (seq, bytes) sent, oldest first
+        std::size_t pendingBytes = 0;
+        bool lagging = false;   ///< resync sent; nothing more until it is acknowledged
+        bool missed = false;    ///< a broadcast was skipped while lagging
+        bool snapshotPending = false;   ///< snapshot still being read; broadcasts are held
+        std::vector<std::pair<std::uint64_t, std::string>> held;   ///< (seq, message) to send after the snapshot
+    };
+
+    mutable std::mutex subscribersMutex_;
+    std::map<crow::websocket::connection*, Subscriber> subscribers_;
+    std::atomic<std::uint64_t> seq_{0};      // of the last broadcast; written by the broadcaster only
+
+    std::mutex pendingMutex_;
+    std::condition_variable pendingCv_;
+    std::unordered_set<int> changed_;
+    std::unordered_set<int> deleted_;
+    bool resync_ = false;
+    bool stop_ = false;
+
+    std::atomic<std::uint64_t> messages_{0};
+    std::atomic<std::uint64_t> resyncs_{0};
+    std::atomic<std::uint64_t> lagResyncs_{0};
+
+    std::thread broadcaster_;
+
+    void broadcastLoop();
+    void broadcast(std::uint64_t seq, const std::string& message);
+
+    /** @brief Queues a message on a subscriber, or its lag resync if that would pass the cap. */
+    void send(crow::websocket::connection& conn, Subscriber& subscriber, std::uint64_t seq, const std::string& message);
+};
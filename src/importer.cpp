@@ -0,0 +1,300 @@
+/**
+ * @file importer.cpp
+ * @brief Implementation of the streaming schedule importer.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "importer.h"
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace importer {
+
+namespace {
+
+// column order used for the parsed field array handed to addRow
+enum Column { kAirline, kPlane, kOrigin, kDestination, kGate, kPassengerCount, kDepartureTime, kColumnCount };
+
+const char* const kColumnNames[kColumnCount] = {
+    "airline", "plane", "origin", "destination", "gate", "passengerCount", "departureTime"
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// size of each block importFile reads from disk
+constexpr std::size_t kReadBlockSize = 64 * 1024;
+
+}
+
+bool parseFormat(const std::string& name, Format& out) {
+    if (name == "csv") { out = Format::Csv; return true; }
+    if (name == "ndjson" || name == "jsonl") { out = Format::Ndjson; return true; }
+    return false;
+}
+
+Progress& progress() {
+    static Progress p;
+    return p;
+}
+
+Session::Session(Db& db, Format format, std::size_t chunkSize)
+    : db_(db), format_(format), chunkSize_(chunkSize > 0 ? chunkSize : 1) {
+    bool idle = false;
+    if (!progress().running.compare_exchange_strong(idle, true)) {
+        throw std::runtime_error("An import is already running");
+    }
+
+    auto& p = progress();
+    p.rowsRead = 0;
+    p.rowsImported = 0;
+    p.rowsFailed = 0;
+    p.chunksCommitted = 0;
+
+    try {
+        refs_ = db_.getReferenceIds();
+    } catch (...) {
+        p.running = false;
+        throw;
+    }
+
+    chunk_.reserve(chunkSize_);
+    chunkRows_.reserve(chunkSize_);
+    for (int& c : columns_) c = -1;
+}
+
+Session::~Session() {
+    progress().running = false;
+}
+
+void Session::feed(std::string_view data) {
+    if (format_ == Format::Csv) feedCsv(data);
+    else feedNdjson(data);
+}
+
+Summary Session::finish() {
+    if (format_ == Format::Csv) {
+        // last record without a trailing newline
+        if (fieldCount_ > 0 || (!record_.empty() && !record_[0].empty())) {
+            endCsvField();
+            endCsvRecord();
+        }
+    } else if (!partialLine_.empty()) {
+        std::string line = std::move(partialLine_);
+        partialLine_.clear();
+        handleJsonLine(line);
+    }
+
+    flushChunk();
+    return summary_;
+}
+
+// CSV (RFC 4180): quoted fields may contain commas, newlines and "" escapes.
+// The parser is a small state machine so fields can span feed() slices.
+void Session::feedCsv(std::string_view data) {
+    for (char c : data) {
+        if (fieldCount_ == record_.size()) record_.emplace_back();
+
+        if (inQuotes_) {
+            if (quoteInQuotes_) {
+                quoteInQuotes_ = false;
+                if (c == '"') {             // "" inside quotes is a literal quote
+                    record_[fieldCount_] += '"';
+                    continue;
+                }
+                inQuotes_ = false;          // closing quote; handle c as unquoted below
+            } else {
+                if (c == '"') quoteInQuotes_ = true;
+                else record_[fieldCount_] += c;
+                continue;
+            }
+        }
+
+        switch (c) {
+        case '"':  inQuotes_ = true; break;
+        case ',':  endCsvField(); break;
+        case '\n': endCsvField(); endCsvRecord(); break;
+        case '\r': break;
+        default:   record_[fieldCount_] += c; break;
+        }
+    }
+}
+
+void Session::endCsvField() {
+    if (fieldCount_ == record_.size()) record_.emplace_back();
+    ++fieldCount_;
+}
+
+void Session::endCsvRecord() {
+    const std::size_t fields = fieldCount_;
+    fieldCount_ = 0;
+
+    // blank line
+    if (fields <= 1 && trim(record_[0]).empty()) {
+        record_[0].clear();
+        return;
+    }
+
+    if (!haveHeader_) {
+        for (std::size_t i = 0; i < fields; ++i) {
+            auto name = trim(record_[i]);
+            for (int col = 0; col < kColumnCount; ++col) {
+                if (name == kColumnNames[col]) columns_[col] = static_cast<int>(i);
+            }
+        }
+        for (int col = 0; col < kColumnCount; ++col) {
+            if (columns_[col] < 0) {
+                throw std::runtime_error(std::string("CSV header is missing column: ") + kColumnNames[col]);
+            }
+        }
+        haveHeader_ = true;
+    } else {
+        std::string_view row[kColumnCount];
+        for (int col = 0; col < kColumnCount; ++col) {
+            auto idx = static_cast<std::size_t>(columns_[col]);
+            row[col] = idx < fields ? std::string_view(record_[idx]) : std::string_view();
+        }
+        addRow(row);
+    }
+
+    for (std::size_t i = 0; i < fields; ++i) record_[i].clear();
+}
+
+void Session::feedNdjson(std::string_view data) {
+    std::size_t start = 0;
+    while (start < data.size()) {
+        auto nl = data.find('\n', start);
+        if (nl == std::string_view::npos) {
+            partialLine_.append(data.substr(start));
+            return;
+        }
+
+        auto line = data.substr(start, nl - start);
+        if (partialLine_.empty()) {
+            handleJsonLine(line);
+        } else {
+            partialLine_.append(line);
+            handleJsonLine(partialLine_);
+            partialLine_.clear();
+        }
+        start = nl + 1;
+    }
+}
+
+void Session::handleJsonLine(std::string_view line) {
+    line = trim(line);
+    if (line.empty()) return;
+
+    auto obj = crow::json::load(line.data(), line.size());
+    if (!obj || obj.t() != crow::json::type::Object) {
+        summary_.rowsRead++;
+        progress().rowsRead++;
+        fail(summary_.rowsRead, "Invalid JSON object");
+        return;
+    }
+
+    std::string values[kColumnCount];
+    for (int col = 0; col < kColumnCount; ++col) {
+        if (!obj.has(kColumnNames[col])) continue;
+        const auto& v = obj[kColumnNames[col]];
+        if (v.t() == crow::json::type::String) values[col] = v.s();
+        else if (v.t() == crow::json::type::Number) values[col] = std::to_string(v.i());
+    }
+
+    std::string_view row[kColumnCount];
+    for (int col = 0; col < kColumnCount; ++col) row[col] = values[col];
+    addRow(row);
+}
+
+void Session::addRow(const std::string_view* fields) {
+    const std::uint64_t rowNumber = ++summary_.rowsRead;
+    progress().rowsRead++;
+
+    auto lookup = [&](const std::unordered_map<std::string, int>& map, int col, int& id) {
+        auto it = map.find(std::string(trim(fields[col])));
+        if (it == map.end()) {
+            fail(rowNumber, std::string("Unknown ") + kColumnNames[col] + ": " + std::string(trim(fields[col])));
+            return false;
+        }
+        id = it->second;
+        return true;
+    };
+
+    FlightInput flight;
+    if (!lookup(refs_.airlineByName, kAirline, flight.airlineID)) return;
+    if (!lookup(refs_.planeByModel, kPlane, flight.planeID)) return;
+    if (!lookup(refs_.airportByCode, kOrigin, flight.originAirportID)) return;
+    if (!lookup(refs_.airportByCode, kDestination, flight.destinationAirportID)) return;
+
+    if (flight.originAirportID == flight.destinationAirportID) {
+        fail(rowNumber, "origin and destination must be different");
+        return;
+    }
+
+    auto count = trim(fields[kPassengerCount]);
+    auto parsed = std::from_chars(count.data(), count.data() + count.size(), flight.passengerCount);
+    if (count.empty() || parsed.ec != std::errc() || parsed.ptr != count.data() + count.size()) {
+        fail(rowNumber, "passengerCount must be an integer");
+        return;
+    }
+
+    flight.gate = std::string(trim(fields[kGate]));
+    flight.departureTime = std::string(trim(fields[kDepartureTime]));
+    if (flight.gate.empty() || flight.departureTime.empty()) {
+        fail(rowNumber, "gate and departureTime are required");
+        return;
+    }
+
+    chunk_.push_back(std::move(flight));
+    chunkRows_.push_back(rowNumber);
+    if (chunk_.size() >= chunkSize_) flushChunk();
+}
+
+void Session::fail(std::uint64_t row, std::string message) {
+    summary_.rowsFailed++;
+    progress().rowsFailed++;
+    if (summary_.errors.size() < kMaxReportedErrors) {
+        summary_.errors.push_back(RowError{row, std::move(message)});
+    }
+}
+
+void Session::flushChunk() {
+    if (chunk_.empty()) return;
+
+    auto results = db_.createFlights(chunk_);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        if (results[i].error.empty()) {
+            summary_.rowsImported++;
+            progress().rowsImported++;
+        } else {
+            fail(chunkRows_[i], results[i].error);
+        }
+    }
+
+    summary_.chunksCommitted++;
+    progress().chunksCommitted++;
+    chunk_.clear();
+    chunkRows_.clear();
+}
+
+Summary importFile(Db& db, const std::string& path, Format format, std::size_t chunkSize) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) throw std::runtime_error("Could not open import file: " + path);
+
+    Session session(db, format, chunkSize);
+    std::vector<char> block(kReadBlockSize);
+    while (in) {
+        in.read(block.data(), static_cast<std::streamsize>(block.size()));
+        auto got = static_cast<std::size_t>(in.gcount());
+        if (got == 0) break;
+        session.feed(std::string_view(block.data(), got));
+    }
+    return session.finish();
+}
+
+}
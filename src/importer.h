@@ -0,0 +1,146 @@
+#pragma once
+
+/**
+ * @file importer.h
+ * @brief Streaming bulk import of flight schedules.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Parses CSV or NDJSON schedules incrementally and inserts them
+ * through Db in fixed-size transactions.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "db.h"
+
+/**
+ * @brief Bulk schedule import.
+ *
+ * Both formats use the same human-readable columns / keys:
+ * airline (name), plane (model), origin and destination (airport codes),
+ * gate, passengerCount and departureTime. CSV files need a header row
+ * naming those columns (any order, extra columns ignored).
+ */
+namespace importer {
+
+/** @brief Input file format. */
+enum class Format { Csv, Ndjson };
+
+/**
+ * @brief Parses a format name ("csv" or "ndjson"/"jsonl").
+ * @param name Format name, case-sensitive.
+ * @param out Parsed format.
+ * @return True if the name is recognised.
+ */
+bool parseFormat(const std::string& name, Format& out);
+
+/**
+ * @brief Live counters for the import in progress (or the last one run).
+ *
+ * Updated while a Session runs so progress can be polled from another thread.
+ */
+struct Progress {
+    std::atomic<bool> running{false};
+    std::atomic<std::uint64_t> rowsRead{0};
+    std::atomic<std::uint64_t> rowsImported{0};
+    std::atomic<std::uint64_t> rowsFailed{0};
+    std::atomic<std::uint64_t> chunksCommitted{0};
+};
+
+/** @brief Returns the process-wide import progress counters. */
+Progress& progress();
+
+/** @brief One rejected row (1-based data row number, header excluded). */
+struct RowError {
+    std::uint64_t row;
+    std::string message;
+};
+
+/** @brief Totals for a finished import. */
+struct Summary {
+    std::uint64_t rowsRead = 0;
+    std::uint64_t rowsImported = 0;
+    std::uint64_t rowsFailed = 0;
+    std::uint64_t chunksCommitted = 0;
+    std::vector<RowError> errors;   ///< first kMaxReportedErrors failures
+};
+
+/** @brief How many row errors a Summary keeps (the rest are only counted). */
+constexpr std::size_t kMaxReportedErrors = 100;
+
+/**
+ * @brief One import run.
+ *
+ * Feed the input in arbitrary slices (lines and CSV fields may span
+ * slices); rows are buffered and committed every chunkSize rows.
+ * Only one session can run at a time per process.
+ */
+class Session {
+public:
+    /**
+     * @brief Starts an import.
+     * @param db Database to insert into.
+     * @param format Input format.
+     * @param chunkSize Rows per transaction (min 1).
+     * @throws std::runtime_error if another import is already running.
+     */
+    Session(Db& db, Format format, std::size_t chunkSize);
+
+    /** @brief Marks the import as no longer running. */
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    /** @brief Parses the next slice of input. */
+    void feed(std::string_view data);
+
+    /** @brief Flushes the last partial row/chunk and returns the totals. */
+    Summary finish();
+
+private:
+    Db& db_;
+    Format format_;
+    std::size_t chunkSize_;
+    ReferenceIds refs_;
+    Summary summary_;
+
+    std::vector<FlightInput> chunk_;
+    std::vector<std::uint64_t> chunkRows_;   // data row number of each chunk_ entry
+
+    // NDJSON: partial line carried over between slices
+    std::string partialLine_;
+
+    // CSV: parser state carried over between slices
+    std::vector<std::string> record_;
+    std::size_t fieldCount_ = 0;
+    bool inQuotes_ = false;
+    bool quoteInQuotes_ = false;
+    bool haveHeader_ = false;
+    int columns_[7];
+
+    void feedCsv(std::string_view data);
+    void feedNdjson(std::string_view data);
+    void endCsvField();
+    void endCsvRecord();
+    void handleJsonLine(std::string_view line);
+    void addRow(const std::string_view* fields);
+    void fail(std::uint64_t row, std::string message);
+    void flushChunk();
+};
+
+/**
+ * @brief Imports a schedule file from disk, reading it in fixed-size blocks.
+ * @param db Database to insert into.
+ * @param path File to read.
+ * @param format Input format.
+ * @param chunkSize Rows per transaction.
+ * @return Import totals.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+Summary importFile(Db& db, const std::string& path, Format format, std::size_t chunkSize);
+
+}
@@ -0,0 +1,164 @@
+/**
+ * @file jsonwriter.cpp
+ * @brief Implementation of the streaming JSON writer and response row writers.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "jsonwriter.h"
+#include "geo.h"
+#include "timeutil.h"
+#include <algorithm>
+#include <cmath>
+
+void JsonWriter::value(double v) {
+    if (!std::isfinite(v)) {
+        null();
+        return;
+    }
+    separate();
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out_.append(buf, static_cast<std::size_t>(res.ptr - buf));
+    first_ = false;
+}
+
+// Escapes like crow::json: quotes, backslashes and control characters.
+// Runs of plain bytes are appended in one go.
+void JsonWriter::appendString(std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+
+    out_ += '"';
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out_.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"':  out_.append("\\\"", 2); break;
+        case '\\': out_.append("\\\\", 2); break;
+        case '\n': out_.append("\\n", 2); break;
+        case '\b': out_.append("\\b", 2); break;
+        case '\f': out_.append("\\f", 2); break;
+        case '\r': out_.append("\\r", 2); break;
+        case '\t': out_.append("\\t", 2); break;
+        default:
+            out_.append("\\u00", 4);
+            out_ += hex[c >> 4];
+            out_ += hex[c & 0xF];
+            break;
+        }
+    }
+    out_.append(s.data() + run, s.size() - run);
+    out_ += '"';
+}
+
+// indexed by FlightStatus
+static const char* const kStatusClass[] = {"boarding", "ontime", "departed"};
+static const char* const kStatusText[] = {"BOARDING", "ON TIME", "DEPARTED"};
+
+void fillDerivedFields(FlightItem& f, std::int64_t nowMs) {
+    f.distanceKm = geo::haversineKm(
+        f.origin.latitude, f.origin.longitude,
+        f.destination.latitude, f.destination.longitude
+    );
+    f.durationMinutes = geo::durationMinutes(f.distanceKm, f.planeSpeed);
+
+    // a departureTime that never parsed has no status, progress or arrival
+    if (!f.hasDepartureEpoch) {
+        f.statusClass = "";
+        f.statusText = "";
+        f.progress = 0.0;
+        f.arrivalTime.clear();
+        return;
+    }
+
+    // progress and status from integer seconds (departureEpoch is UTC)
+    const FlightStatus status = statusAt(f.departureEpoch, nowMs / 1000);
+    f.statusClass = kStatusClass[static_cast<int>(status)];
+    f.statusText = kStatusText[static_cast<int>(status)];
+
+    // Progress: 0 at (departure - 30 min), 1.0 at departure
+    const std::int64_t boardingStartMs = (f.departureEpoch - kBoardingSeconds) * 1000;
+    double progress = static_cast<double>(nowMs - boardingStartMs) / (kBoardingSeconds * 1000);
+    f.progress = std::min(std::max(progress, 0.0), 1.0);
+
+    char arrival[timeutil::kIso8601UtcLength];
+    char* end = timeutil::formatIso8601Utc(f.departureEpoch + f.durationMinutes * 60, arrival);
+    f.arrivalTime.assign(arrival, end);
+}
+
+static void writeAirport(JsonWriter& w, const FlightItem::Airport& a) {
+    w.beginObject();
+    w.key("city");      w.value(a.city);
+    w.key("code");      w.value(a.code);
+    w.key("latitude");  w.value(a.latitude);
+    w.key("longitude"); w.value(a.longitude);
+    w.endObject();
+}
+
+void writeJson(JsonWriter& w, const FlightItem& f) {
+    w.beginObject();
+    w.key("flightID"); w.value(f.flightID);
+
+    w.key("airline");
+    w.beginObject();
+    w.key("name");     w.value(f.airlineName);
+    w.key("logoPath"); w.value(f.airlineLogoPath);
+    w.endObject();
+
+    w.key("plane");         w.value(f.plane);
+    w.key("gate");          w.value(f.gate);
+    w.key("passengers");    w.value(f.passengers);
+    w.key("departureTime"); w.value(f.departureTime);
+
+    w.key("status");
+    w.beginObject();
+    w.key("class"); w.value(f.statusClass);
+    w.key("text");  w.value(f.statusText);
+    w.endObject();
+    w.key("progress"); w.value(f.progress);
+
+    w.key("origin");      writeAirport(w, f.origin);
+    w.key("destination"); writeAirport(w, f.destination);
+
+    // "<h>h <m>m" without a temporary string
+    char duration[32];
+    char* p = std::to_chars(duration, duration + 12, f.durationMinutes / 60).ptr;
+    *p++ = 'h';
+    *p++ = ' ';
+    p = std::to_chars(p, p + 12, f.durationMinutes % 60).ptr;
+    *p++ = 'm';
+
+    w.key("distanceKm");      w.value(f.distanceKm);
+    w.key("durationMinutes"); w.value(f.durationMinutes);
+    w.key("durationText");    w.value(std::string_view(duration, static_cast<std::size_t>(p - duration)));
+    w.key("arrivalTime");     w.value(f.arrivalTime);
+    w.endObject();
+}
+
+void writeJson(JsonWriter& w, const PlaneRow& p) {
+    w.beginObject();
+    w.key("planeID");  w.value(p.planeID);
+    w.key("model");    w.value(p.model);
+    w.key("speed");    w.value(p.speed);
+    w.key("maxSeats"); w.value(p.maxSeats);
+    w.endObject();
+}
+
+void writeJson(JsonWriter& w, const AirportRow& a) {
+    w.beginObject();
+    w.key("airportID"); w.value(a.airportID);
+    w.key("code");      w.value(a.code);
+    w.key("city");      w.value(a.city);
+    w.endObject();
+}
+
+void writeJson(JsonWriter& w, const AirlineRow& a) {
+    w.beginObject();
+    w.key("airlineID"); w.value(a.airlineID);
+    w.key("name");      w.value(a.name);
+    w.key("logoPath");  w.value(a.logoPath);
+    w.endObject();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+/**
+ * @file jsonwriter.h
+ * @brief Append-only JSON writer for API responses.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Writes JSON text straight into one output string instead of building a
+ * crow::json::wvalue tree and dumping it afterwards.
+ */
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "db.h"
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * Commas are inserted automatically, so callers only open/close containers,
+ * write keys and write values. Keys must be string literals that need no
+ * escaping; their length is known at compile time.
+ *
+ * @code
+ * JsonWriter w(256);
+ * w.beginObject();
+ * w.key("total"); w.value(42);
+ * w.endObject();
+ * res.body = w.take();
+ * @endcode
+ */
+class JsonWriter {
+public:
+    /** @param reserveBytes Initial buffer capacity (use a size estimate to avoid regrowth). */
+    explicit JsonWriter(std::size_t reserveBytes = 0) { out_.reserve(reserveBytes); }
+
+    void beginObject() { separate(); out_ += '{'; first_ = true; }
+    void endObject() { out_ += '}'; first_ = false; }
+    void beginArray() { separate(); out_ += '['; first_ = true; }
+    void endArray() { out_ += ']'; first_ = false; }
+
+    /** @brief Writes an object key; the next value belongs to it. */
+    template <std::size_t N>
+    void key(const char (&name)[N]) {
+        separate();
+        out_ += '"';
+        out_.append(name, N - 1);
+        out_.append("\":", 2);
+        first_ = true;
+    }
+
+    void value(std::string_view s) { separate(); appendString(s); first_ = false; }
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(const std::string& s) { value(std::string_view(s)); }
+    void value(int v) { appendNumber(v); }
+    void value(std::int64_t v) { appendNumber(v); }
+    void value(std::uint64_t v) { appendNumber(v); }
+    /** @brief Writes a double in shortest round-trip form; NaN/inf become null. */
+    void value(double v);
+    void value(bool v) { separate(); out_ += v ? "true" : "false"; first_ = false; }
+    void null() { separate(); out_ += "null"; first_ = false; }
+
+    /** @brief The JSON written so far. */
+    const std::string& str() const { return out_; }
+
+    /** @brief Moves the JSON out; the writer is left empty. */
+    std::string take() { first_ = true; return std::move(out_); }
+
+    /** @brief Empties the writer but keeps its capacity for reuse. */
+    void clear() { out_.clear(); first_ = true; }
+
+private:
+    std::string out_;
+    bool first_ = true;   // no comma needed before the next element
+
+    void separate() { if (!first_) out_ += ','; }
+    void appendString(std::string_view s);
+
+    template <typename T>
+    void appendNumber(T v) {
+        separate();
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.append(buf, static_cast<std::size_t>(res.ptr - buf));
+        first_ = false;
+    }
+};
+
+/** @brief Rough serialized size of one flight, for presizing list responses. */
+constexpr std::size_t kFlightJsonBytes = 640;
+
+/**
+ * @brief Fills in a flight's status, progress, distance, duration and arrival time.
+ *
+ * Legacy rows without a departureEpoch get an empty status and arrival time.
+ * @param f Flight as read from the board.
+ * @param nowMs Reference time, UTC epoch milliseconds; every flight in one
+ *        response should use the same value.
+ */
+void fillDerivedFields(FlightItem& f, std::int64_t nowMs);
+
+/**
+ * @brief Writes one flight in the GET /api/flights item format.
+ *
+ * Expects the derived fields to be filled in already (fillDerivedFields).
+ */
+void writeJson(JsonWriter& w, const FlightItem& f);
+
+/** @brief Writes one plane as returned by GET /api/planes. */
+void writeJson(JsonWriter& w, const PlaneRow& p);
+
+/** @brief Writes one airport as returned by GET /api/airports. */
+void writeJson(JsonWriter& w, const AirportRow& a);
+
+/** @brief Writes one airline as returned by GET /api/airlines. */
+void writeJson(JsonWriter& w, const AirlineRow& a);
+
+/**
+ * @brief Serializes {"<name>": [rows...]} for the reference list routes.
+ * @param name Top-level key, e.g. "planes".
+ * @param rows Rows to write with writeJson.
+ */
+template <std::size_t N, typename Row>
+std::string writeJsonList(const char (&name)[N], const std::vector<Row>& rows) {
+    JsonWriter w(32 + rows.size() * 96);
+    w.beginObject();
+    w.key(name);
+    w.beginArray();
+    for (const auto& row : rows) writeJson(w, row);
+    w.endArray();
+    w.endObject();
+    return w.take();
+}
@@ -8,120 +8,434 @@
 
 
 #include "crow_all.h"
+#include "compression.h"
 #include "db.h"
-#include "geo.h"
+#include "flightstream.h"
+#include "importer.h"
+#include "jsonwriter.h"
+#include "metrics.h"
+#include "responsecache.h"
+#include "slowquerylog.h"
+#include "staticfiles.h"
 #include "timeutil.h"
 #include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <algorithm>
-#include <ctime>
-#include <iomanip>
-#include <map>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
 
 /**
- * @brief In-memory flight model used to enrich API responses.
+ * @brief Checks a request's If-None-Match header against an entity tag.
  *
- * Built from database query results and used to compute
- * status, distance, duration, and arrival time.
+ * Accepts a comma-separated list and "*"; W/ prefixes are ignored, as
+ * If-None-Match uses weak comparison.
+ * @param req Incoming request.
+ * @param etag Quoted entity tag of the current representation.
+ * @return True if the client already holds it (answer 304).
  */
-struct FlightItem {
-    int flightID;
-    std::string airlineName;
-    std::string airlineLogoPath;
-    std::string plane;
-    int planeSpeed =0;
-    std::string arrivalTime;
-    double distanceKm =0.0;
-    int durationMinutes = 0;
-    std::string gate;
-    int passengers;
-    std::string departureTime;
-    
-    struct Airport {
-        std::string city;
-        std::string code;
-        double latitude;
-        double longitude;
-    } origin, destination;
-};
+static bool etagMatches(const crow::request& req, const std::string& etag) {
+    const std::string& header = req.get_header_value("If-None-Match");
+    std::size_t pos = 0;
+    while (pos < header.size()) {
+        std::size_t end = header.find(',', pos);
+        if (end == std::string::npos) end = header.size();
+
+        std::size_t a = pos, b = end;
+        while (a < b && (header[a] == ' ' || header[a] == '\t')) ++a;
+        while (b > a && (header[b - 1] == ' ' || header[b - 1] == '\t')) --b;
+        if (b - a >= 2 && header.compare(a, 2, "W/") == 0) a += 2;
+
+        if ((b - a == 1 && header[a] == '*') || header.compare(a, b - a, etag) == 0) return true;
+        pos = end + 1;
+    }
+    return false;
+}
 
 /**
- * @brief Reads an entire file into a string.
- * @param path File path.
- * @return File contents, or empty string if open fails.
+ * @brief Builds a 304 Not Modified response.
+ * @param etag Entity tag to echo back.
+ * @param cacheControl Cache-Control value, same as the 200 response would carry.
  */
-static std::string readFile(const std::string& path) {
-    std::ifstream in(path, std::ios::in);
-    if (!in) return "";
-    std::ostringstream ss;
-    ss << in.rdbuf();
-    return ss.str();
+static crow::response notModified(const std::string& etag, const char* cacheControl) {
+    crow::response res;
+    res.code = 304;
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", cacheControl);
+    return res;
 }
 
 /**
- * @brief Serves a static file as an HTTP response.
- * @param path File path on disk.
- * @param contentType Value for the Content-Type header.
- * @return 200 response with file contents, or 404 if missing.
+ * @brief Serves a file from the in-memory static store.
+ *
+ * Sends the precompressed variant the client accepts (so the compression
+ * middleware is told to leave the body alone), with Last-Modified and a
+ * per-variant ETag, or 304 if the client's copy is still current.
+ * @param files Static file store.
+ * @param req Incoming request (Accept-Encoding and conditional headers).
+ * @param path Path relative to /public, e.g. "styles/main.css".
+ * @return 200 response with file contents, 304, or 404 if missing.
  */
-static crow::response serveFile(const std::string& path, const std::string& contentType) {
-    auto body = readFile(path);
-    if (body.empty()) return crow::response(404, "Not Found");
-    crow::response res{200, body};
-    res.set_header("Content-Type", contentType);
+static crow::response serveStatic(const StaticFiles& files, const crow::request& req, const std::string& path) {
+    const auto file = files.find(path);
+    if (!file) return crow::response(404, "Not Found");
+
+    compression::Encoding used;
+    const std::string& body = file->variant(compression::negotiate(req.get_header_value("Accept-Encoding")), used);
+    const std::string etag = file->etagFor(used);
+
+    // If-None-Match wins over If-Modified-Since when both are sent
+    bool current;
+    if (!req.get_header_value("If-None-Match").empty()) {
+        current = etagMatches(req, etag);
+    } else {
+        std::int64_t since;
+        current = timeutil::parseHttpDate(req.get_header_value("If-Modified-Since"), since)
+            && file->modifiedEpoch <= since;
+    }
+
+    crow::response res;
+    res.compressed = false;
+    if (current) {
+        res.code = 304;
+    } else {
+        res.code = 200;
+        res.body = body;   // Crow responses own their body: one copy from memory
+        res.set_header("Content-Type", file->contentType);
+        if (used != compression::Encoding::Identity) res.set_header("Content-Encoding", compression::encodingName(used));
+    }
+    res.set_header("ETag", etag);
+    res.set_header("Last-Modified", file->lastModified);
+    if (!file->gzip.empty() || !file->deflate.empty()) res.set_header("Vary", "Accept-Encoding");
     return res;
 }
 
+// Flight lists may change with any write: clients must revalidate every time.
+static const char* const kFlightsCacheControl = "no-cache";
+// Reference rows change rarely but can be edited in place (the board
+// triggers follow them): their tag moves with the data version, and a
+// client may show an old list for up to max-age before revalidating.
+static const char* const kReferenceCacheControl = "public, max-age=300";
+
+/**
+ * @brief Cursor tag for a sort mode.
+ *
+ * Status cursors append the FlightStatus segment of the last row
+ * ("status:1"), since a status page can end part-way through any segment.
+ */
+static std::string cursorIndexFor(const std::string& sort, int segment) {
+    if (sort == "gate") return "gate";
+    if (sort == "status") return "status:" + std::to_string(segment);
+    return "departure";
+}
+
+/**
+ * @brief Encodes a keyset position as an opaque, URL-safe cursor.
+ * @param sort Sort mode of the page.
+ * @param pos Sort key (departureEpoch or gate), flightID and status segment
+ *        of the last row returned.
+ * @return Base64url cursor string (no padding).
+ */
+static std::string encodeCursor(const std::string& sort, const FlightCursor& pos) {
+    std::string raw = cursorIndexFor(sort, pos.segment) + "\n" + std::to_string(pos.flightID) + "\n" + pos.key;
+    std::string enc = crow::utility::base64encode_urlsafe(raw, raw.size());
+    while (!enc.empty() && enc.back() == '=') enc.pop_back();
+    return enc;
+}
+
 /**
- * @brief Converts a JSON list of flights into FlightItem objects.
- * @param flightsJson JSON list returned from the database layer.
- * @return Vector of FlightItem records.
+ * @brief Decodes a cursor produced by encodeCursor.
+ * @param cursor Cursor string from the query.
+ * @param sort Sort mode of the current request; must match the cursor's.
+ * @param out Decoded keyset position.
+ * @return True if the cursor is well-formed and belongs to this sort mode.
  */
-std::vector<FlightItem> jsonToFlights(const crow::json::rvalue& flightsJson) {
-    std::vector<FlightItem> result;
-
-    for (size_t i = 0; i < flightsJson.size(); ++i) {
-        const auto& f = flightsJson[i];
-        FlightItem item;
-
-        item.flightID      = f["flightID"].i();
-        item.airlineName   = f["airline"]["name"].s();
-        item.airlineLogoPath = f["airline"]["logoPath"].s();
-        item.plane         = f["plane"].s();
-        item.planeSpeed = f["planeSpeed"].i();
-        item.gate          = f["gate"].s();
-        item.passengers    = f["passengers"].i();
-        item.departureTime = f["departureTime"].s();
-
-        item.origin.city      = f["origin"]["city"].s();
-        item.origin.code      = f["origin"]["code"].s();
-        item.origin.latitude  = f["origin"]["latitude"].d();
-        item.origin.longitude = f["origin"]["longitude"].d();
-
-        item.destination.city      = f["destination"]["city"].s();
-        item.destination.code      = f["destination"]["code"].s();
-        item.destination.latitude  = f["destination"]["latitude"].d();
-        item.destination.longitude = f["destination"]["longitude"].d();
-
-        result.push_back(item);
+static bool decodeCursor(const std::string& cursor, const std::string& sort, FlightCursor& out) {
+    std::string raw = crow::utility::base64decode(cursor);
+    auto first = raw.find('\n');
+    if (first == std::string::npos) return false;
+    auto second = raw.find('\n', first + 1);
+    if (second == std::string::npos) return false;
+
+    bool tagMatches = false;
+    for (int seg = 0; seg < (sort == "status" ? kStatusSegments : 1) && !tagMatches; ++seg) {
+        if (raw.compare(0, first, cursorIndexFor(sort, seg)) == 0) {
+            out.segment = seg;
+            tagMatches = true;
+        }
     }
-    return result;
+    if (!tagMatches) return false;
+
+    std::string id = raw.substr(first + 1, second - first - 1);
+    if (id.empty() || id.find_first_not_of("0123456789") != std::string::npos) return false;
+
+    out.flightID = std::atoi(id.c_str());
+    out.key = raw.substr(second + 1);
+
+    // departure and status cursors carry departureEpoch
+    if (sort != "gate") {
+        std::size_t digits = out.key.size() > 0 && out.key[0] == '-' ? 1 : 0;
+        if (digits == out.key.size() || out.key.find_first_not_of("0123456789", digits) != std::string::npos) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads and validates the fields of a flight create payload.
+ * @param body Parsed JSON object.
+ * @param out Filled with the flight fields on success.
+ * @param error Set to a client-facing message on failure.
+ * @return True if the payload is a valid flight.
+ */
+static bool parseFlightInput(const crow::json::rvalue& body, FlightInput& out, std::string& error) {
+    if (body.t() != crow::json::type::Object) {
+        error = "Expected a JSON object";
+        return false;
+    }
+
+    const char* intFields[] = {
+        "planeID","originAirportID","destinationAirportID",
+        "airlineID","passengerCount"
+    };
+    const char* textFields[] = {"gate","departureTime"};
+
+    for (auto f : intFields) {
+        if (!body.has(f)) { error = std::string("Missing field: ") + f; return false; }
+        if (body[f].t() != crow::json::type::Number) { error = std::string("Field must be a number: ") + f; return false; }
+    }
+    for (auto f : textFields) {
+        if (!body.has(f)) { error = std::string("Missing field: ") + f; return false; }
+        if (body[f].t() != crow::json::type::String) { error = std::string("Field must be a string: ") + f; return false; }
+    }
+
+    out.planeID = body["planeID"].i();
+    out.airlineID = body["airlineID"].i();
+    out.originAirportID = body["originAirportID"].i();
+    out.destinationAirportID = body["destinationAirportID"].i();
+    out.gate = body["gate"].s();
+    out.passengerCount = body["passengerCount"].i();
+    out.departureTime = body["departureTime"].s();
+
+    if (out.originAirportID == out.destinationAirportID) {
+        error = "originAirportID and destinationAirportID must be different";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts an import summary to JSON.
+ * @param summary Finished import totals.
+ * @return JSON object with counters and the first row errors.
+ */
+static crow::json::wvalue importSummaryJson(const importer::Summary& summary) {
+    crow::json::wvalue out;
+    out["rowsRead"] = summary.rowsRead;
+    out["rowsImported"] = summary.rowsImported;
+    out["rowsFailed"] = summary.rowsFailed;
+    out["chunksCommitted"] = summary.chunksCommitted;
+
+    std::vector<crow::json::wvalue> errors;
+    for (const auto& e : summary.errors) {
+        crow::json::wvalue j;
+        j["row"] = e.row;
+        j["error"] = e.message;
+        errors.push_back(std::move(j));
+    }
+    out["errors"] = std::move(errors);
+    return out;
+}
+
+/**
+ * @brief Runs a command-line schedule import instead of the HTTP server.
+ *
+ * Usage: server [--db-profile NAME] --import FILE [--format csv|ndjson] [--chunk N]
+ * The format defaults from the file extension (.csv, otherwise NDJSON).
+ *
+ * @return Process exit code.
+ */
+static int runImportCommand(Db& db, int argc, char** argv) {
+    std::string path;
+    std::string format;
+    std::size_t chunk = 5000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--import" && i + 1 < argc) path = argv[++i];
+        else if (arg == "--format" && i + 1 < argc) format = argv[++i];
+        else if (arg == "--chunk" && i + 1 < argc) chunk = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+    }
+
+    if (format.empty()) {
+        format = (path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) ? "csv" : "ndjson";
+    }
+
+    importer::Format fmt;
+    if (path.empty() || !importer::parseFormat(format, fmt)) {
+        std::cerr << "usage: server --import FILE [--format csv|ndjson] [--chunk N]" << std::endl;
+        return 2;
+    }
+
+    // report progress on stderr once a second while the import runs
+    std::atomic<bool> done{false};
+    std::thread reporter([&done]{
+        auto& p = importer::progress();
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (done) break;
+            std::cerr << "imported " << p.rowsImported << " / read " << p.rowsRead
+                      << " (failed " << p.rowsFailed << ", chunks " << p.chunksCommitted << ")" << std::endl;
+        }
+    });
+
+    int code = 0;
+    try {
+        auto summary = importer::importFile(db, path, fmt, chunk);
+        std::cout << importSummaryJson(summary).dump() << std::endl;
+        code = summary.rowsFailed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "import failed: " << e.what() << std::endl;
+        code = 1;
+    }
+
+    done = true;
+    reporter.join();
+    return code;
 }
 
 /**
  * @brief Application entry point. DUHHHHHHHH
  *
  * Initializes the database, configures API routes, and starts the HTTP server.
+ * With --import it loads a schedule file and exits instead (see runImportCommand).
  */
-int main() {
+int main(int argc, char** argv) {
     // init db
+    // reader pool size: FLIGHTS_DB_READERS, defaults to one per core (same as crow's worker count)
+    int readers = static_cast<int>(std::thread::hardware_concurrency());
+    if (const char* env = std::getenv("FLIGHTS_DB_READERS")) {
+        readers = std::atoi(env);
+    }
+
+    // group-commit window for the writer thread: FLIGHTS_DB_FLUSH_MS (default 2ms)
+    int flushMs = 2;
+    if (const char* env = std::getenv("FLIGHTS_DB_FLUSH_MS")) {
+        flushMs = std::atoi(env);
+    }
+
+    // SQLite durability/performance preset: --db-profile NAME or FLIGHTS_DB_PROFILE
+    std::string profileName = "durable";
+    if (const char* env = std::getenv("FLIGHTS_DB_PROFILE")) {
+        profileName = env;
+    }
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--db-profile") profileName = argv[i + 1];
+    }
+    DbProfile profile;
+    if (!parseDbProfile(profileName, profile)) {
+        std::cerr << "unknown db profile '" << profileName << "' (durable, balanced, fast)" << std::endl;
+        return 2;
+    }
+
     std::filesystem::create_directories("/app/runtime_db");
-    Db db("/app/runtime_db/flights.db");
+    const std::string dbPath = "/app/runtime_db/flights.db";
+
+    // slow-query log: statements over FLIGHTS_SLOW_QUERY_MS (default 100, fractions
+    // allowed, negative disables) go to FLIGHTS_SLOW_QUERY_LOG with their query
+    // plan, rotated past FLIGHTS_SLOW_QUERY_LOG_BYTES (default 10 MB).
+    // Declared before db so it outlives the Db's writer thread.
+    double slowQueryMs = 100;
+    if (const char* env = std::getenv("FLIGHTS_SLOW_QUERY_MS")) {
+        slowQueryMs = std::atof(env);
+    }
+    std::unique_ptr<SlowQueryLog> slowQueryLog;
+    if (slowQueryMs >= 0) {
+        SlowQueryLog::Options options;
+        options.threshold = std::chrono::nanoseconds(static_cast<std::int64_t>(slowQueryMs * 1e6));
+        options.path = "/app/runtime_db/slow-queries.log";
+        if (const char* env = std::getenv("FLIGHTS_SLOW_QUERY_LOG")) {
+            options.path = env;
+        }
+        if (const char* env = std::getenv("FLIGHTS_SLOW_QUERY_LOG_BYTES")) {
+            options.maxBytes = static_cast<std::uintmax_t>(std::max(4096LL, std::atoll(env)));
+        }
+        slowQueryLog = std::make_unique<SlowQueryLog>(dbPath, options);
+    }
+
+    Db db(dbPath, readers, flushMs, profile);
+    db.setSlowQueryLog(slowQueryLog.get());
     db.initSchema("/app/src/schema.sql");
     db.seedIfEmpty("/app/src/seed.sql");
 
-    crow::SimpleApp app;
+    // GET /api/flights response cache: FLIGHTS_CACHE_ENTRIES (default 256, 0 disables)
+    // and the status/progress refresh bucket FLIGHTS_CACHE_BUCKET_SECONDS (default 5s)
+    std::size_t cacheEntries = 256;
+    if (const char* env = std::getenv("FLIGHTS_CACHE_ENTRIES")) {
+        cacheEntries = static_cast<std::size_t>(std::max(0, std::atoi(env)));
+    }
+    int bucketSeconds = 5;
+    if (const char* env = std::getenv("FLIGHTS_CACHE_BUCKET_SECONDS")) {
+        bucketSeconds = std::max(1, std::atoi(env));
+    }
+    ResponseCache flightsCache(cacheEntries);
+    const std::int64_t bucketMs = static_cast<std::int64_t>(bucketSeconds) * 1000;
+
+    // Entity tags carry dataVersion(), which moves with every commit to the
+    // database file, whichever process made it. They start with the process
+    // start time: the counter restarts at 0, so tags from a previous run
+    // must never match.
+    const std::string etagPrefix = "\"" + std::to_string(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    auto referenceEtag = [&db, &etagPrefix] {
+        return etagPrefix + "-ref-" + std::to_string(db.dataVersion()) + '"';
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--import") return runImportCommand(db, argc, argv);
+    }
+
+    // Response compression: bodies of at least FLIGHTS_COMPRESSION_MIN_BYTES
+    // (default 1024) at zlib level FLIGHTS_COMPRESSION_LEVEL (default 6, 0 disables)
+    std::size_t compressionMinBytes = 1024;
+    if (const char* env = std::getenv("FLIGHTS_COMPRESSION_MIN_BYTES")) {
+        compressionMinBytes = static_cast<std::size_t>(std::max(0, std::atoi(env)));
+    }
+    int compressionLevel = 6;
+    if (const char* env = std::getenv("FLIGHTS_COMPRESSION_LEVEL")) {
+        compressionLevel = std::min(9, std::max(0, std::atoi(env)));
+    }
+
+    // /public is loaded (and precompressed) once and served from memory;
+    // FLIGHTS_STATIC_RELOAD=1 reloads it when files change
+    StaticFiles staticFiles("/app/public", compressionMinBytes);
+    if (const char* env = std::getenv("FLIGHTS_STATIC_RELOAD"); env && std::atoi(env) > 0) {
+        if (!staticFiles.watch()) std::cerr << "static file reload unavailable (inotify)" << std::endl;
+    }
+
+    // Crow reads a request body into memory before any handler runs, so
+    // POST /api/import refuses bodies over FLIGHTS_IMPORT_MAX_BYTES (default
+    // 32 MiB, 0 lifts the limit); larger schedules go through --import
+    std::size_t importMaxBytes = 32 * 1024 * 1024;
+    if (const char* env = std::getenv("FLIGHTS_IMPORT_MAX_BYTES")) {
+        importMaxBytes = static_cast<std::size_t>(std::max(0LL, std::atoll(env)));
+        if (importMaxBytes == 0) importMaxBytes = SIZE_MAX;
+    }
+
+    // live board updates for /api/flights/stream
+    FlightStream flightStream(db, FlightStream::Options{});
+
+    // HttpMetrics first, so request latency includes compressing the response
+    crow::App<HttpMetrics, HttpCompression> app;
+    auto& httpCompression = app.get_middleware<HttpCompression>();
+    httpCompression.minBytes = compressionLevel > 0 ? compressionMinBytes : SIZE_MAX;
+    httpCompression.level = compressionLevel;
 
     /**
     * @brief GET /
@@ -141,17 +455,39 @@ int main() {
      * Query params:
      * - search: optional keyword filter
      * - sort: departure | gate | status
-     * - date: optional date filter
+     * - date: optional day filter, departures in [date, date + 1 day)
+     * - from, to: optional departure window [from, to); either may be
+     *   omitted and each overrides the matching end of date
      * - page: page number (1-based)
+     * - cursor: opaque keyset cursor from a previous response's nextCursor
+     *   (takes precedence over page)
      */
     CROW_ROUTE(app, "/api/flights").methods(crow::HTTPMethod::GET)
-    ([&db](const crow::request& req){
+    ([&db, &flightsCache, bucketMs, &etagPrefix](const crow::request& req){
         std::string search = req.url_params.get("search") ? req.url_params.get("search") : "";
         std::string sort   = req.url_params.get("sort") ? req.url_params.get("sort") : "status";
-        std::string dateStr = req.url_params.get("date") ? req.url_params.get("date") : "";
-        // normalize datetime-local format (YYYY-MM-DDTHH:MM -> YYYY-MM-DD HH:MM)
-        if (!dateStr.empty()) {
-            std::replace(dateStr.begin(), dateStr.end(), 'T', ' ');
+
+        // Departure window [from, to): date=D is [D, D + 1 day); from/to
+        // override either end. Any form timeutil::parseDateTime accepts.
+        // An empty value (the board sends date= until a day is picked) is no bound.
+        auto bound = [&req](const char* name) -> const char* {
+            const char* value = req.url_params.get(name);
+            return value && *value ? value : nullptr;
+        };
+        TimeWindow window;
+        std::int64_t t;
+        if (const char* date = bound("date")) {
+            if (!timeutil::parseDateTime(date, t)) return crow::response{400, "Invalid date"};
+            window.from = t;
+            window.to = t + 24 * 60 * 60;
+        }
+        if (const char* from = bound("from")) {
+            if (!timeutil::parseDateTime(from, t)) return crow::response{400, "Invalid from"};
+            window.from = t;
+        }
+        if (const char* to = bound("to")) {
+            if (!timeutil::parseDateTime(to, t)) return crow::response{400, "Invalid to"};
+            window.to = t;
         }
 
         // normalize sort (avoid weird values)
@@ -167,216 +503,366 @@ int main() {
 
         int offset = (page - 1) * size;
 
-        // Pull only 100 rows from DB (sorted by departure/gate in SQL)
-       auto flightsWvalue = db.getFlightsPage(size, offset, sort, search, dateStr);
-
-        // Convert to rvalue -> vector<FlightItem>
-        std::string jsonStr = flightsWvalue.dump();
-        auto flightsRvalue = crow::json::load(jsonStr);
-        auto flights = jsonToFlights(flightsRvalue);
-
-        // Search filter 
-        
-
-        // Helper functions for status and progress 
-        auto now = std::chrono::system_clock::now();
-
-        auto getStatus = [&](const FlightItem& f) -> std::pair<std::string, std::string> {
-            std::tm depTm = {};
-            std::istringstream ds(f.departureTime);
-            ds >> std::get_time(&depTm, "%Y-%m-%dT%H:%M:%S");
-            auto dep = std::chrono::system_clock::from_time_t(std::mktime(&depTm));
-            auto diff = std::chrono::duration_cast<std::chrono::minutes>(dep - now).count();
-
-            if (diff < 0) return {"departed", "DEPARTED"};
-            if (diff < 30) return {"boarding", "BOARDING"};
-            return {"ontime", "ON TIME"};
-        };
-
-        auto getProgress = [&](const FlightItem& f) -> double {
-            std::tm depTm = {};
-            std::istringstream ds(f.departureTime);
-            ds >> std::get_time(&depTm, "%Y-%m-%dT%H:%M:%S");
-            auto dep = std::chrono::system_clock::from_time_t(std::mktime(&depTm));
-
-            // Progress: 0 at (departure - 30 min), 1.0 at departure
-            auto boardingStart = dep - std::chrono::minutes(30);
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - boardingStart).count();
-            auto total = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::minutes(30)).count();
-
-            double progress = static_cast<double>(elapsed) / total;
-            return std::min(std::max(progress, 0.0), 1.0);
-        };
-
-        // Sorting
-        if (sort != "departure" && sort != "gate") {
-            std::map<std::string,int> statusOrder = {{"boarding",0}, {"ontime",1}, {"departed",2}};
-            std::sort(flights.begin(), flights.end(), [&](const FlightItem& a, const FlightItem& b){
-                auto statusA = getStatus(a).first;
-                auto statusB = getStatus(b).first;
-                return statusOrder[statusA] < statusOrder[statusB];
-            });
+        // Keyset pagination: a cursor seeks straight to the next page
+        // through the sort index instead of skipping `offset` rows.
+        std::optional<FlightCursor> after;
+        if (req.url_params.get("cursor")) {
+            FlightCursor cursor;
+            if (!decodeCursor(req.url_params.get("cursor"), sort, cursor))
+                return crow::response{400, "Invalid cursor"};
+            after = cursor;
+            offset = 0;
         }
 
-        // Convert to JSON with status and progress
-        crow::json::wvalue out;
-        std::vector<crow::json::wvalue> flightsList;
-
-        for (auto& f : flights) {
-            crow::json::wvalue j;
-
-            j["flightID"] = f.flightID;
-            j["airline"]["name"] = f.airlineName;
-            j["airline"]["logoPath"] = f.airlineLogoPath;
-            j["plane"] = f.plane;
-            j["gate"] = f.gate;
-            j["passengers"] = f.passengers;
-            j["departureTime"] = f.departureTime;
-
-            // Add status and progress
-            auto [statusClass, statusText] = getStatus(f);
-            j["status"]["class"] = statusClass;
-            j["status"]["text"] = statusText;
-            j["progress"] = getProgress(f);
-
-            j["origin"]["city"] = f.origin.city;
-            j["origin"]["code"] = f.origin.code;
-            j["origin"]["latitude"] = f.origin.latitude;
-            j["origin"]["longitude"] = f.origin.longitude;
-
-            j["destination"]["city"] = f.destination.city;
-            j["destination"]["code"] = f.destination.code;
-            j["destination"]["latitude"] = f.destination.latitude;
-            j["destination"]["longitude"] = f.destination.longitude;
-
-
-            f.distanceKm = geo::haversineKm(
-                f.origin.latitude, f.origin.longitude,
-                f.destination.latitude, f.destination.longitude
-            );
-            f.durationMinutes = geo::durationMinutes(f.distanceKm, f.planeSpeed);
-
-            std::chrono::system_clock::time_point depTp;
-            if (timeutil::parseIso8601Utc(f.departureTime, depTp)) {
-                auto arrTp = depTp + std::chrono::minutes(f.durationMinutes);
-                f.arrivalTime = timeutil::formatIso8601Utc(arrTp);
-            } else {
-                f.arrivalTime = "";
-            }
+        // Status segments and each row's status use the same "now", rounded
+        // down to the cache bucket so a cached page stays consistent with it
+        const std::int64_t bucket = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() / bucketMs;
+        const std::int64_t nowMs = bucket * bucketMs;
+        const std::int64_t now = nowMs / 1000;
+
+        // Same normalized query, no write since (by this or any other process,
+        // see Db::dataVersion) and same time bucket: reuse the body. The
+        // version is read before the query (see ResponseCache::put).
+        const std::uint64_t version = db.dataVersion();
+        std::string cacheKey = sort;
+        cacheKey += '\x1f';
+        cacheKey += search;
+        cacheKey += '\x1f';
+        if (window.from) cacheKey += std::to_string(*window.from);
+        cacheKey += '\x1f';
+        if (window.to) cacheKey += std::to_string(*window.to);
+        cacheKey += '\x1f';
+        cacheKey += std::to_string(page);
+        if (after) {
+            cacheKey += '\x1f';
+            cacheKey += req.url_params.get("cursor");
+        }
 
-            int h = f.durationMinutes / 60;
-            int m = f.durationMinutes % 60;
-            std::string durationText = std::to_string(h) + "h " + std::to_string(m) + "m";
+        // The body is fully determined by (data version, time bucket, query),
+        // so a matching tag is answered without touching the DB.
+        char keyHash[17];
+        *std::to_chars(keyHash, keyHash + 16, std::hash<std::string>{}(cacheKey), 16).ptr = '\0';
+        const std::string etag = etagPrefix + '-' + std::to_string(version) + '-'
+            + std::to_string(bucket) + '-' + keyHash + '"';
+        if (etagMatches(req, etag)) return notModified(etag, kFlightsCacheControl);
 
-            j["distanceKm"] = f.distanceKm;
-            j["durationMinutes"] = f.durationMinutes;
-            j["durationText"] = durationText;
-            j["arrivalTime"] = f.arrivalTime;
+        auto respond = [&etag](const std::string& body) {
+            crow::response res{200, body};
+            res.set_header("Content-Type", "application/json");
+            res.set_header("ETag", etag);
+            res.set_header("Cache-Control", kFlightsCacheControl);
+            return res;
+        };
 
-            flightsList.push_back(std::move(j));
+        if (auto cached = flightsCache.get(cacheKey, version, bucket)) return respond(*cached);
+
+        // Pull one extra row from DB (already in sort order, status included) to know if another page follows.
+        // The matching total comes back with the page (cached per search/date until the next write).
+        int total = 0;
+        auto flights = db.getFlightsPage(size + 1, offset, sort, search, window, now, total, after);
+
+        // Cursor for the next page comes from the last row returned
+        std::string nextCursor;
+        if (static_cast<int>(flights.size()) > size) {
+            flights.resize(size);
+            const auto& last = flights.back();
+            FlightCursor pos;
+            pos.key = sort == "gate" ? last.gate : std::to_string(last.departureEpoch);
+            pos.flightID = last.flightID;
+            pos.segment = static_cast<int>(statusAt(last.departureEpoch, now));
+            nextCursor = encodeCursor(sort, pos);
         }
 
-        // Pagination metadata (NOTE: total is unfiltered for now)
-        int total = db.getFlightsCount(search, dateStr);
-        out["page"] = page;
-        out["size"] = size;
-        out["total"] = total;
-        out["totalPages"] = (total + size - 1) / size;
-
-        out["flights"] = std::move(flightsList);
-
-        crow::response res;
-        res.code = 200;
-        res.set_header("Content-Type", "application/json");
-        res.body = out.dump();
-        return res;
+        // Derived fields, then one pass straight into the response buffer
+        for (auto& f : flights) fillDerivedFields(f, nowMs);
+
+        JsonWriter out(256 + flights.size() * kFlightJsonBytes);
+        out.beginObject();
+
+        // Pagination metadata
+        out.key("page");       out.value(page);
+        out.key("size");       out.value(size);
+        out.key("total");      out.value(total);
+        out.key("totalPages"); out.value((total + size - 1) / size);
+        out.key("nextCursor");
+        if (nextCursor.empty()) out.null();
+        else out.value(nextCursor);
+
+        out.key("flights");
+        out.beginArray();
+        for (const auto& f : flights) writeJson(out, f);
+        out.endArray();
+        out.endObject();
+
+        auto body = std::make_shared<const std::string>(out.take());
+        flightsCache.put(cacheKey, version, bucket, body);
+        return respond(*body);
     });
-    // assets routes (images, gifs)
-    CROW_ROUTE(app, "/assets/<string>")([](const std::string& file){
-        return serveFile("/app/public/assets/" + file, "image/gif");
+    // assets routes (images, gifs); content types come from the file extension
+    CROW_ROUTE(app, "/assets/<string>")([&staticFiles](const crow::request& req, const std::string& file){
+        return serveStatic(staticFiles, req, "assets/" + file);
     });
 
     //assets route for the logos
     CROW_ROUTE(app, "/assets/<string>/<string>")
-    ([](const std::string& folder, const std::string& file){
-        return serveFile("/app/public/assets/" + folder + "/" + file, "image/png");
+    ([&staticFiles](const crow::request& req, const std::string& folder, const std::string& file){
+        return serveStatic(staticFiles, req, "assets/" + folder + "/" + file);
     });
 
 
     // pages routes
-    CROW_ROUTE(app, "/pages/<string>")([](const std::string& file){
-        return serveFile("/app/public/pages/" + file, "text/html; charset=utf-8");
+    CROW_ROUTE(app, "/pages/<string>")([&staticFiles](const crow::request& req, const std::string& file){
+        return serveStatic(staticFiles, req, "pages/" + file);
     });
 
     // styles routes
-    CROW_ROUTE(app, "/styles/<string>")([](const std::string& file){
-        return serveFile("/app/public/styles/" + file, "text/css; charset=utf-8");
+    CROW_ROUTE(app, "/styles/<string>")([&staticFiles](const crow::request& req, const std::string& file){
+        return serveStatic(staticFiles, req, "styles/" + file);
     });
 
     //scripts routes
-    CROW_ROUTE(app, "/scripts/<string>")([](const std::string& file){
-        return serveFile("/app/public/scripts/" + file, "application/javascript; charset=utf-8");
+    CROW_ROUTE(app, "/scripts/<string>")([&staticFiles](const crow::request& req, const std::string& file){
+        return serveStatic(staticFiles, req, "scripts/" + file);
     });
 
     CROW_ROUTE(app, "/api/planes").methods(crow::HTTPMethod::GET)
+    ([&db, &referenceEtag](const crow::request& req){
+        const std::string etag = referenceEtag();
+        if (etagMatches(req, etag)) return notModified(etag, kReferenceCacheControl);
+        crow::response res{200, writeJsonList("planes", db.getAllPlanes())};
+        res.set_header("Content-Type", "application/json");
+        res.set_header("ETag", etag);
+        res.set_header("Cache-Control", kReferenceCacheControl);
+        return res;
+    });
+
+    CROW_ROUTE(app, "/api/airports").methods(crow::HTTPMethod::GET)
+    ([&db, &referenceEtag](const crow::request& req){
+        const std::string etag = referenceEtag();
+        if (etagMatches(req, etag)) return notModified(etag, kReferenceCacheControl);
+        crow::response res{200, writeJsonList("airports", db.getAllAirports())};
+        res.set_header("Content-Type", "application/json");
+        res.set_header("ETag", etag);
+        res.set_header("Cache-Control", kReferenceCacheControl);
+        return res;
+    });
+
+    CROW_ROUTE(app, "/api/airlines").methods(crow::HTTPMethod::GET)
+    ([&db, &referenceEtag](const crow::request& req){
+        const std::string etag = referenceEtag();
+        if (etagMatches(req, etag)) return notModified(etag, kReferenceCacheControl);
+        crow::response res{200, writeJsonList("airlines", db.getAllAirlines())};
+        res.set_header("Content-Type", "application/json");
+        res.set_header("ETag", etag);
+        res.set_header("Cache-Control", kReferenceCacheControl);
+        return res;
+    });
+    
+    /**
+     * @brief GET /admin/db-stats
+     * @brief Reports connection pool size and prepared statement cache counters.
+     */
+    CROW_ROUTE(app, "/admin/db-stats").methods(crow::HTTPMethod::GET)
     ([&db]{
+        auto cache = db.statementCacheStats();
         crow::json::wvalue out;
-        out["planes"] = db.getAllPlanes();
+        out["readers"] = db.readerCount();
+        out["profile"] = dbProfileName(db.profile());
+        out["statementCache"]["hits"] = cache.hits;
+        out["statementCache"]["misses"] = cache.misses;
         crow::response res{200, out.dump()};
         res.set_header("Content-Type", "application/json");
         return res;
     });
 
-    CROW_ROUTE(app, "/api/airports").methods(crow::HTTPMethod::GET)
-    ([&db]{
+    /**
+     * @brief GET /admin/sql-stats
+     * @brief Per-statement SQL profile (calls, time, rows, VM steps), slowest total first,
+     * and slow-query log counters.
+     *
+     * Query params:
+     * - limit: max statements listed (default all)
+     */
+    CROW_ROUTE(app, "/admin/sql-stats").methods(crow::HTTPMethod::GET)
+    ([&db, &slowQueryLog](const crow::request& req){
+        auto stats = db.sqlStats();
+        if (const char* param = req.url_params.get("limit")) {
+            const int limit = std::atoi(param);
+            if (limit >= 0 && static_cast<std::size_t>(limit) < stats.size()) stats.resize(static_cast<std::size_t>(limit));
+        }
+
         crow::json::wvalue out;
-        out["airports"] = db.getAllAirports();
+        out["statements"] = crow::json::wvalue::list();
+        for (std::size_t i = 0; i < stats.size(); ++i) {
+            const auto& s = stats[i];
+            auto& item = out["statements"][i];
+            item["sql"] = s.sql;
+            item["calls"] = s.calls;
+            item["totalMs"] = s.totalNs / 1e6;
+            item["avgMs"] = s.calls ? s.totalNs / 1e6 / static_cast<double>(s.calls) : 0.0;
+            item["maxMs"] = s.maxNs / 1e6;
+            item["rows"] = s.rows;
+            item["vmSteps"] = s.vmSteps;
+            item["fullScanSteps"] = s.fullScanSteps;
+        }
+        if (slowQueryLog) {
+            auto slow = slowQueryLog->stats();
+            out["slowQueries"]["thresholdMs"] = slowQueryLog->threshold().count() / 1e6;
+            out["slowQueries"]["logged"] = slow.logged;
+            out["slowQueries"]["dropped"] = slow.dropped;
+        }
         crow::response res{200, out.dump()};
         res.set_header("Content-Type", "application/json");
         return res;
     });
 
-    CROW_ROUTE(app, "/api/airlines").methods(crow::HTTPMethod::GET)
-    ([&db]{
+    /**
+     * @brief GET /metrics
+     * @brief Request counts, latency histograms, in-flight requests and Db
+     * call timings in Prometheus text format.
+     */
+    CROW_ROUTE(app, "/metrics").methods(crow::HTTPMethod::GET)
+    ([]{
+        crow::response res{200, metrics::renderPrometheus()};
+        res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return res;
+    });
+
+    /**
+     * @brief GET /admin/cache-stats
+     * @brief Reports GET /api/flights response cache counters.
+     */
+    CROW_ROUTE(app, "/admin/cache-stats").methods(crow::HTTPMethod::GET)
+    ([&flightsCache, bucketSeconds]{
+        auto stats = flightsCache.stats();
         crow::json::wvalue out;
-        out["airlines"] = db.getAllAirlines();
+        out["hits"] = stats.hits;
+        out["misses"] = stats.misses;
+        out["evictions"] = stats.evictions;
+        out["stale"] = stats.stale;
+        out["entries"] = stats.entries;
+        out["capacity"] = stats.capacity;
+        out["bucketSeconds"] = bucketSeconds;
         crow::response res{200, out.dump()};
         res.set_header("Content-Type", "application/json");
         return res;
     });
-    
+
+    /**
+     * @brief GET /api/flights/changes
+     * @brief Flights created, updated or deleted after a change-log version.
+     *
+     * Query params:
+     * - since: last version the client has (default 0: everything)
+     * - limit: max entries (default 1000, at most 5000); "more" is true when
+     *   the list was cut short, and "version" is where to continue from
+     */
+    CROW_ROUTE(app, "/api/flights/changes").methods(crow::HTTPMethod::GET)
+    ([&db](const crow::request& req){
+        std::int64_t since = 0;
+        if (const char* param = req.url_params.get("since")) {
+            const char* end = param + std::strlen(param);
+            auto parsed = std::from_chars(param, end, since);
+            if (parsed.ec != std::errc() || parsed.ptr != end || since < 0) return crow::response{400, "Invalid since"};
+        }
+
+        int limit = 1000;
+        if (req.url_params.get("limit"))
+            limit = std::min(5000, std::max(1, std::atoi(req.url_params.get("limit"))));
+
+        try {
+            auto changes = db.getFlightChanges(since, limit);
+            const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+            JsonWriter out(128 + changes.flights.size() * kFlightJsonBytes + changes.deleted.size() * 12);
+            out.beginObject();
+            out.key("since");   out.value(since);
+            out.key("version"); out.value(changes.version);
+            out.key("more");    out.value(changes.more);
+            out.key("flights");
+            out.beginArray();
+            for (auto& f : changes.flights) {
+                fillDerivedFields(f, nowMs);
+                writeJson(out, f);
+            }
+            out.endArray();
+            out.key("deleted");
+            out.beginArray();
+            for (int id : changes.deleted) out.value(id);
+            out.endArray();
+            out.endObject();
+
+            crow::response res{200, out.take()};
+            res.set_header("Content-Type", "application/json");
+            return res;
+        } catch (const std::exception& e) {
+            return crow::response{500, e.what()};
+        }
+    });
+
+    /**
+     * @brief WebSocket /api/flights/stream
+     * @brief Live board: a snapshot on connect, then changed flights (see FlightStream).
+     */
+    CROW_WEBSOCKET_ROUTE(app, "/api/flights/stream")
+        .max_payload(1024)   // clients only send acks
+        .onopen([&flightStream](crow::websocket::connection& conn){
+            flightStream.subscribe(conn);
+        })
+        .onmessage([&flightStream](crow::websocket::connection& conn, const std::string& data, bool){
+            flightStream.received(conn, data);
+        })
+        .onclose([&flightStream](crow::websocket::connection& conn, const std::string&, uint16_t){
+            flightStream.unsubscribe(conn);
+        })
+        .onerror([&flightStream](crow::websocket::connection& conn, const std::string&){
+            flightStream.unsubscribe(conn);
+        });
+
+    /**
+     * @brief GET /admin/stream-stats
+     * @brief Reports live stream subscribers and broadcast counters.
+     */
+    CROW_ROUTE(app, "/admin/stream-stats").methods(crow::HTTPMethod::GET)
+    ([&flightStream]{
+        auto stats = flightStream.stats();
+        crow::json::wvalue out;
+        out["subscribers"] = stats.subscribers;
+        out["messages"] = stats.messages;
+        out["resyncs"] = stats.resyncs;
+        out["lagging"] = stats.lagging;
+        out["lagResyncs"] = stats.lagResyncs;
+        crow::response res{200, out.dump()};
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
+
     /**
      * @brief POST /api/flights
      * @brief Creates a new flight record.
      */
     CROW_ROUTE(app, "/api/flights").methods(crow::HTTPMethod::POST)
-    ([&db](const crow::request& req){
+    ([&db, &flightStream](const crow::request& req){
         auto body = crow::json::load(req.body);
         if (!body) return crow::response{400, "Invalid JSON"};
 
-        const char* fields[] = {
-            "planeID","originAirportID","destinationAirportID",
-            "airlineID","gate","passengerCount","departureTime"
-        };
-
-        for (auto f : fields) {
-            if (!body.has(f)) return crow::response{400, std::string("Missing field: ") + f};
-        }
-
-        if (body["originAirportID"].i() == body["destinationAirportID"].i()) {
-            return crow::response{400, "originAirportID and destinationAirportID must be different"};
-        }
+        FlightInput flight;
+        std::string error;
+        if (!parseFlightInput(body, flight, error)) return crow::response{400, error};
 
         try {
             int id = db.createFlight(
-                body["planeID"].i(),
-                body["airlineID"].i(),
-                body["originAirportID"].i(),
-                body["destinationAirportID"].i(),
-                body["gate"].s(),
-                body["passengerCount"].i(),
-                body["departureTime"].s()
+                flight.planeID,
+                flight.airlineID,
+                flight.originAirportID,
+                flight.destinationAirportID,
+                flight.gate,
+                flight.passengerCount,
+                flight.departureTime
             );
+            flightStream.flightChanged(id);
 
             crow::json::wvalue out;
             out["message"] = "Flight created";
@@ -387,11 +873,166 @@ int main() {
             res.set_header("Content-Type", "application/json");
             res.body = out.dump();;
             return res;
+        } catch (const std::invalid_argument& e) {
+            return crow::response{400, e.what()};
         } catch (const std::exception& e) {
             return crow::response{500, e.what()};
         }
     });
 
+    /**
+     * @brief POST /api/flights/batch
+     * @brief Creates many flights in one transaction.
+     *
+     * Body is a JSON array of flight objects (same fields as POST /api/flights).
+     * Every item is validated first; valid items are inserted together and
+     * the response lists a flightID or an error for each item, in order.
+     */
+    CROW_ROUTE(app, "/api/flights/batch").methods(crow::HTTPMethod::POST)
+    ([&db, &flightStream](const crow::request& req){
+        auto body = crow::json::load(req.body);
+        if (!body) return crow::response{400, "Invalid JSON"};
+        if (body.t() != crow::json::type::List) return crow::response{400, "Expected a JSON array of flights"};
+
+        const size_t count = body.size();
+        std::vector<FlightInput> valid;
+        std::vector<size_t> validIndex;      // position of each valid item in the request
+        std::vector<std::string> errors(count);
+        valid.reserve(count);
+        validIndex.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            FlightInput flight;
+            if (parseFlightInput(body[i], flight, errors[i])) {
+                valid.push_back(std::move(flight));
+                validIndex.push_back(i);
+            }
+        }
+
+        std::vector<BatchItemResult> inserted;
+        try {
+            inserted = db.createFlights(valid);
+        } catch (const std::exception& e) {
+            return crow::response{500, e.what()};
+        }
+
+        std::vector<int> ids(count, 0);
+        for (size_t k = 0; k < inserted.size(); ++k) {
+            if (inserted[k].error.empty()) {
+                ids[validIndex[k]] = inserted[k].flightID;
+                flightStream.flightChanged(inserted[k].flightID);
+            } else {
+                errors[validIndex[k]] = inserted[k].error;
+            }
+        }
+
+        int created = 0;
+        std::vector<crow::json::wvalue> results;
+        results.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            crow::json::wvalue r;
+            r["index"] = static_cast<int>(i);
+            if (ids[i] > 0) {
+                r["flightID"] = ids[i];
+                ++created;
+            } else {
+                r["error"] = errors[i];
+            }
+            results.push_back(std::move(r));
+        }
+
+        crow::json::wvalue out;
+        out["created"] = created;
+        out["failed"] = static_cast<int>(count) - created;
+        out["results"] = std::move(results);
+
+        crow::response res;
+        res.code = created > 0 ? 201 : 400;
+        res.set_header("Content-Type", "application/json");
+        res.body = out.dump();
+        return res;
+    });
+
+
+    /**
+     * @brief POST /api/import
+     * @brief Bulk-loads a CSV or NDJSON schedule from the request body.
+     *
+     * The upload is not streamed: Crow has the whole body in memory before
+     * this runs. Bodies over FLIGHTS_IMPORT_MAX_BYTES get 413; load big
+     * schedules from disk with `server --import FILE`, which reads the file
+     * in blocks.
+     *
+     * Query params:
+     * - format: csv | ndjson (defaults from Content-Type, else csv)
+     * - chunk: rows per transaction (default 5000)
+     */
+    CROW_ROUTE(app, "/api/import").methods(crow::HTTPMethod::POST)
+    ([&db, &flightStream, importMaxBytes](const crow::request& req){
+        if (req.body.size() > importMaxBytes) {
+            return crow::response{413, "import body over " + std::to_string(importMaxBytes)
+                + " bytes; use server --import FILE for large schedules"};
+        }
+
+        std::string format = req.url_params.get("format") ? req.url_params.get("format") : "";
+        if (format.empty()) {
+            const auto& type = req.get_header_value("Content-Type");
+            format = (type.find("ndjson") != std::string::npos || type.find("jsonl") != std::string::npos) ? "ndjson" : "csv";
+        }
+
+        importer::Format fmt;
+        if (!importer::parseFormat(format, fmt)) return crow::response{400, "format must be csv or ndjson"};
+
+        std::size_t chunk = 5000;
+        if (req.url_params.get("chunk"))
+            chunk = static_cast<std::size_t>(std::max(1, std::atoi(req.url_params.get("chunk"))));
+
+        std::unique_ptr<importer::Session> session;
+        try {
+            session = std::make_unique<importer::Session>(db, fmt, chunk);
+        } catch (const std::exception& e) {
+            return crow::response{409, e.what()};
+        }
+
+        // chunks commit as they go, so even a failed import may have changed the board
+        struct ResyncOnExit {
+            FlightStream& stream;
+            ~ResyncOnExit() { stream.resync(); }
+        } resyncOnExit{flightStream};
+
+        try {
+            // already buffered by Crow; parsed in place, no per-line copies
+            session->feed(req.body);
+            auto summary = session->finish();
+
+            crow::response res;
+            res.code = 200;
+            res.set_header("Content-Type", "application/json");
+            res.body = importSummaryJson(summary).dump();
+            return res;
+        } catch (const std::exception& e) {
+            return crow::response{400, e.what()};
+        }
+    });
+
+    /**
+     * @brief GET /api/import/status
+     * @brief Progress counters of the running (or last) import.
+     */
+    CROW_ROUTE(app, "/api/import/status").methods(crow::HTTPMethod::GET)
+    ([]{
+        auto& p = importer::progress();
+        crow::json::wvalue out;
+        out["running"] = p.running.load();
+        out["rowsRead"] = p.rowsRead.load();
+        out["rowsImported"] = p.rowsImported.load();
+        out["rowsFailed"] = p.rowsFailed.load();
+        out["chunksCommitted"] = p.chunksCommitted.load();
+
+        crow::response res{200, out.dump()};
+        res.set_header("Content-Type", "application/json");
+        return res;
+    });
 
     /**
      * @brief GET /api/flights/{id}
@@ -417,7 +1058,7 @@ int main() {
 
     /** @brief PUT /api/flights/{id} @brief Replaces a flight record. */
     CROW_ROUTE(app, "/api/flights/<int>").methods(crow::HTTPMethod::PUT)
-    ([&db](const crow::request& req, int flightID){
+    ([&db, &flightStream](const crow::request& req, int flightID){
         auto body = crow::json::load(req.body);
         if (!body) return crow::response{400, "Invalid JSON"};
 
@@ -453,6 +1094,7 @@ int main() {
             );
 
             if (!ok) return crow::response{404, "Flight not found"};
+            flightStream.flightChanged(flightID);
 
             crow::json::wvalue out;
             out["message"] = "Flight updated";
@@ -463,6 +1105,8 @@ int main() {
             res.set_header("Content-Type", "application/json");
             res.body = out.dump();
             return res;
+        } catch (const std::invalid_argument& e) {
+            return crow::response{400, e.what()};
         } catch (const std::exception& e) {
             return crow::response{500, e.what()};
         }
@@ -470,7 +1114,7 @@ int main() {
 
     /** @brief PATCH /api/flights/{id} @brief Partially updates a flight record. */
     CROW_ROUTE(app, "/api/flights/<int>").methods(crow::HTTPMethod::PATCH)
-    ([&db](const crow::request& req, int flightID){
+    ([&db, &flightStream](const crow::request& req, int flightID){
         auto body = crow::json::load(req.body);
         if (!body) return crow::response{400, "Invalid JSON"};
 
@@ -534,6 +1178,7 @@ int main() {
             );
 
             if (!ok) return crow::response{404, "Flight not found"};
+            flightStream.flightChanged(flightID);
 
             crow::json::wvalue out;
             out["message"] = "Flight patched";
@@ -545,6 +1190,8 @@ int main() {
             res.body = out.dump();
             return res;
 
+        } catch (const std::invalid_argument& e) {
+            return crow::response{400, e.what()};
         } catch (const std::exception& e) {
             return crow::response{500, e.what()};
         }
@@ -554,10 +1201,11 @@ int main() {
 
     /** @brief DELETE /api/flights/{id} @brief Deletes a flight record. */
     CROW_ROUTE(app, "/api/flights/<int>").methods(crow::HTTPMethod::DELETE)
-    ([&db](int flightID){
+    ([&db, &flightStream](int flightID){
         try {
             bool ok = db.deleteFlight(flightID);
             if (!ok) return crow::response{404, "Flight not found"};
+            flightStream.flightDeleted(flightID);
 
             crow::json::wvalue out;
             out["message"] = "Flight deleted";
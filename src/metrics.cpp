@@ -0,0 +1,291 @@
+/**
+ * @file metrics.cpp
+ * @brief Implementation of the request and database metrics.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "metrics.h"
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace metrics {
+
+namespace {
+
+constexpr int kCodeClasses = 5;                                  // 1xx .. 5xx
+constexpr std::size_t kBuckets = kBucketBounds.size() + 1;      // + the +Inf bucket
+
+struct Histogram {
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};   // not cumulative; summed at render
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sumMicros{0};
+
+    void observe(std::chrono::steady_clock::duration elapsed) {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::size_t bucket = 0;
+        while (bucket < kBucketBounds.size() && seconds > kBucketBounds[bucket]) ++bucket;
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sumMicros.fetch_add(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()), std::memory_order_relaxed);
+    }
+};
+
+struct HttpSeries {
+    std::array<std::atomic<std::uint64_t>, kCodeClasses> codes{};
+    std::atomic<std::int64_t> inFlight{0};   // a request may finish on another thread; only the sum is meaningful
+    Histogram latency;
+};
+
+// One per thread that ever recorded something. Only its own thread writes
+// it; scrapes read it. Never freed, so a scrape can't race a thread exit.
+struct Shard {
+    std::array<HttpSeries, kMaxHttpSeries> http;
+    std::array<Histogram, kMaxDbSeries> db;
+};
+
+std::mutex shardsMutex;
+std::vector<Shard*> shards;
+
+Shard& localShard() {
+    thread_local Shard* shard = [] {
+        auto* s = new Shard();
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        shards.push_back(s);
+        return s;
+    }();
+    return *shard;
+}
+
+// Series names are written once under the mutex, before the count that
+// makes them visible is published, and never change afterwards.
+template <int N>
+struct Registry {
+    std::mutex mutex;
+    std::array<std::string, N> names;
+    std::unordered_map<std::string, int> ids;
+    std::atomic<int> count{0};
+
+    // returns -1 when full
+    int find(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        const int n = count.load(std::memory_order_relaxed);
+        if (n == N) return -1;
+        names[n] = name;
+        ids.emplace(name, n);
+        count.store(n + 1, std::memory_order_release);
+        return n;
+    }
+};
+
+// HTTP series names are "METHOD route"; ID 0 is the overflow series
+Registry<kMaxHttpSeries>& httpRegistry() {
+    static Registry<kMaxHttpSeries>* registry = [] {
+        auto* r = new Registry<kMaxHttpSeries>();
+        r->find("other other");
+        return r;
+    }();
+    return *registry;
+}
+
+Registry<kMaxDbSeries>& dbRegistry() {
+    static auto* registry = new Registry<kMaxDbSeries>();
+    return *registry;
+}
+
+int httpSeries(const std::string& name) {
+    thread_local std::unordered_map<std::string, int> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) return it->second;
+    int id = httpRegistry().find(name);
+    if (id < 0) id = 0;
+    cache.emplace(name, id);
+    return id;
+}
+
+bool isNumber(const std::string& s, std::size_t begin, std::size_t end) {
+    if (begin == end) return false;
+    for (std::size_t i = begin; i < end; ++i) {
+        if (s[i] < '0' || s[i] > '9') return false;
+    }
+    return true;
+}
+
+// label values escape backslash, double quote and newline
+void appendLabel(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+}
+
+void appendDouble(std::string& out, double value) {
+    char buf[32];
+    const int n = std::snprintf(buf, sizeof(buf), "%.6g", value);
+    out.append(buf, static_cast<std::size_t>(n));
+}
+
+// Sums one histogram across shards and appends its _bucket/_sum/_count lines.
+// labels is the already-formatted label list without braces ("op=\"x\"").
+template <typename Get>
+void appendHistogram(std::string& out, const char* name, const std::string& labels,
+                     const std::vector<Shard*>& all, Get get) {
+    std::array<std::uint64_t, kBuckets> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t sumMicros = 0;
+    for (const Shard* shard : all) {
+        const Histogram& h = get(*shard);
+        for (std::size_t i = 0; i < kBuckets; ++i) buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+        count += h.count.load(std::memory_order_relaxed);
+        sumMicros += h.sumMicros.load(std::memory_order_relaxed);
+    }
+    if (count == 0) return;
+
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        cumulative += buckets[i];
+        out += name; out += "_bucket{"; out += labels; out += ",le=\"";
+        if (i < kBucketBounds.size()) appendDouble(out, kBucketBounds[i]);
+        else out += "+Inf";
+        out += "\"} "; out += std::to_string(cumulative); out += '\n';
+    }
+    out += name; out += "_sum{"; out += labels; out += "} ";
+    appendDouble(out, static_cast<double>(sumMicros) / 1e6);
+    out += '\n';
+    out += name; out += "_count{"; out += labels; out += "} "; out += std::to_string(count); out += '\n';
+}
+
+}
+
+std::string routeLabel(const std::string& path) {
+    static const char* const kStaticTrees[] = {"/assets/", "/pages/", "/styles/", "/scripts/"};
+    for (const char* tree : kStaticTrees) {
+        const std::string prefix(tree);
+        if (path.compare(0, prefix.size(), prefix) == 0) return prefix + "*";
+    }
+
+    std::string out;
+    out.reserve(path.size());
+    std::size_t pos = 0;
+    while (pos < path.size()) {
+        if (path[pos] == '/') {
+            out += '/';
+            ++pos;
+            continue;
+        }
+        std::size_t end = path.find('/', pos);
+        if (end == std::string::npos) end = path.size();
+        if (isNumber(path, pos, end)) out += "<int>";
+        else out.append(path, pos, end - pos);
+        pos = end;
+    }
+    return out;
+}
+
+int dbSeries(const char* name) {
+    // there are far fewer Db methods than slots; past that they share the last one
+    const int id = dbRegistry().find(name);
+    return id < 0 ? kMaxDbSeries - 1 : id;
+}
+
+void observeDb(int series, std::chrono::steady_clock::duration elapsed) {
+    localShard().db[series].observe(elapsed);
+}
+
+std::string renderPrometheus() {
+    std::vector<Shard*> all;
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        all = shards;
+    }
+    auto& http = httpRegistry();
+    auto& db = dbRegistry();
+    const int httpCount = http.count.load(std::memory_order_acquire);
+    const int dbCount = db.count.load(std::memory_order_acquire);
+
+    // "method=\"GET\",route=\"/api/flights\"" per series
+    std::vector<std::string> httpLabels(httpCount);
+    for (int i = 0; i < httpCount; ++i) {
+        const std::string& name = http.names[i];
+        const auto space = name.find(' ');
+        std::string& labels = httpLabels[i];
+        labels += "method=\""; appendLabel(labels, name.substr(0, space));
+        labels += "\",route=\""; appendLabel(labels, name.substr(space + 1));
+        labels += '"';
+    }
+
+    std::string out;
+    out.reserve(16384);
+
+    out += "# HELP http_requests_total HTTP requests by method, route and status class.\n";
+    out += "# TYPE http_requests_total counter\n";
+    static const char* const kCodeLabels[kCodeClasses] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+    for (int i = 0; i < httpCount; ++i) {
+        for (int c = 0; c < kCodeClasses; ++c) {
+            std::uint64_t total = 0;
+            for (const Shard* shard : all) total += shard->http[i].codes[c].load(std::memory_order_relaxed);
+            if (total == 0) continue;
+            out += "http_requests_total{"; out += httpLabels[i];
+            out += ",code=\""; out += kCodeLabels[c]; out += "\"} ";
+            out += std::to_string(total); out += '\n';
+        }
+    }
+
+    out += "# HELP http_requests_in_flight HTTP requests being handled.\n";
+    out += "# TYPE http_requests_in_flight gauge\n";
+    for (int i = 0; i < httpCount; ++i) {
+        std::int64_t inFlight = 0;
+        for (const Shard* shard : all) inFlight += shard->http[i].inFlight.load(std::memory_order_relaxed);
+        out += "http_requests_in_flight{"; out += httpLabels[i]; out += "} ";
+        out += std::to_string(inFlight); out += '\n';
+    }
+
+    out += "# HELP http_request_duration_seconds HTTP request latency, middleware included.\n";
+    out += "# TYPE http_request_duration_seconds histogram\n";
+    for (int i = 0; i < httpCount; ++i) {
+        appendHistogram(out, "http_request_duration_seconds", httpLabels[i], all,
+                        [i](const Shard& s) -> const Histogram& { return s.http[i].latency; });
+    }
+
+    out += "# HELP db_call_duration_seconds Db method latency, waiting for a connection included.\n";
+    out += "# TYPE db_call_duration_seconds histogram\n";
+    for (int i = 0; i < dbCount; ++i) {
+        std::string labels = "op=\"";
+        appendLabel(labels, db.names[i]);
+        labels += '"';
+        appendHistogram(out, "db_call_duration_seconds", labels, all,
+                        [i](const Shard& s) -> const Histogram& { return s.db[i]; });
+    }
+
+    return out;
+}
+
+}
+
+void HttpMetrics::before_handle(crow::request& req, crow::response&, context& ctx) {
+    // Crow runs before_handle for WebSocket upgrades but never after_handle,
+    // so they are not counted (the gauge would never come back down)
+    if (req.upgrade) return;
+
+    ctx.series = metrics::httpSeries(std::string(crow::method_name(req.method)) + ' ' + metrics::routeLabel(req.url));
+    ctx.start = std::chrono::steady_clock::now();
+    metrics::localShard().http[ctx.series].inFlight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HttpMetrics::after_handle(crow::request&, crow::response& res, context& ctx) {
+    if (ctx.series < 0) return;
+
+    auto& series = metrics::localShard().http[ctx.series];
+    const int codeClass = res.code / 100 - 1;
+    if (codeClass >= 0 && codeClass < metrics::kCodeClasses) {
+        series.codes[codeClass].fetch_add(1, std::memory_order_relaxed);
+    }
+    series.latency.observe(std::chrono::steady_clock::now() - ctx.start);
+    series.inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
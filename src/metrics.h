@@ -0,0 +1,95 @@
+#pragma once
+
+/**
+ * @file metrics.h
+ * @brief Request and database metrics in Prometheus text format.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Counters, in-flight gauges and fixed-bucket latency histograms per
+ * (method, route) and per Db call, exposed by GET /metrics.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "crow_all.h"
+
+/**
+ * @brief Process-wide metrics.
+ *
+ * Every thread records into its own shard of relaxed atomics, so the hot
+ * path takes no lock and shares no cache lines with other threads; a
+ * scrape sums the shards. Series (one per method + route, one per Db
+ * call) get a small integer ID the first time they are seen.
+ */
+namespace metrics {
+
+/** @brief Upper bounds (seconds) of the latency histogram buckets; +Inf is implicit. */
+constexpr std::array<double, 14> kBucketBounds = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+    0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5,
+};
+
+/** @brief Most distinct (method, route) series; later ones are counted as method="other", route="other". */
+constexpr int kMaxHttpSeries = 128;
+
+/** @brief Most distinct Db call names. */
+constexpr int kMaxDbSeries = 32;
+
+/**
+ * @brief Route label for a request path.
+ *
+ * Numeric segments become "<int>" and the static file trees collapse to
+ * one label per tree, so flight IDs and file names don't create series.
+ */
+std::string routeLabel(const std::string& path);
+
+/** @brief Returns the series ID for a Db call name (register once, e.g. in a static). */
+int dbSeries(const char* name);
+
+/** @brief Records one Db call. */
+void observeDb(int series, std::chrono::steady_clock::duration elapsed);
+
+/**
+ * @brief Times a Db call from construction to destruction.
+ *
+ * @code
+ * static const int series = metrics::dbSeries("getFlightsPage");
+ * metrics::DbTimer timer(series);
+ * @endcode
+ */
+class DbTimer {
+public:
+    explicit DbTimer(int series) : series_(series), start_(std::chrono::steady_clock::now()) {}
+    ~DbTimer() { observeDb(series_, std::chrono::steady_clock::now() - start_); }
+
+    DbTimer(const DbTimer&) = delete;
+    DbTimer& operator=(const DbTimer&) = delete;
+
+private:
+    int series_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/** @brief Renders every metric in Prometheus text exposition format 0.0.4. */
+std::string renderPrometheus();
+
+}
+
+/**
+ * @brief Crow middleware recording request counts, latency and in-flight requests.
+ *
+ * Put it first in the middleware list so its latency covers the others
+ * (after_handle runs in reverse order).
+ */
+struct HttpMetrics {
+    struct context {
+        int series = -1;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+};
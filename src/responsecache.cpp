@@ -0,0 +1,76 @@
+/**
+ * @file responsecache.cpp
+ * @brief Implementation of the response cache.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "responsecache.h"
+
+ResponseCache::ResponseCache(std::size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
+}
+
+std::shared_ptr<const std::string> ResponseCache::get(const std::string& key,
+                                                      std::uint64_t version,
+                                                      std::int64_t bucket) {
+    if (capacity_ == 0) {
+        misses_++;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+
+    auto entry = it->second;
+    if (entry->version != version || entry->bucket != bucket) {
+        lru_.erase(entry);
+        index_.erase(it);
+        stale_++;
+        misses_++;
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, entry);
+    hits_++;
+    return entry->body;
+}
+
+void ResponseCache::put(const std::string& key, std::uint64_t version, std::int64_t bucket,
+                        std::shared_ptr<const std::string> body) {
+    if (capacity_ == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        // a concurrent miss for the same key got here first; keep the newer build
+        auto entry = it->second;
+        if (entry->version > version || (entry->version == version && entry->bucket >= bucket)) return;
+        entry->version = version;
+        entry->bucket = bucket;
+        entry->body = std::move(body);
+        lru_.splice(lru_.begin(), lru_, entry);
+        return;
+    }
+
+    if (lru_.size() >= capacity_) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        evictions_++;
+    }
+
+    lru_.push_front(Entry{key, version, bucket, std::move(body)});
+    index_.emplace(key, lru_.begin());
+}
+
+ResponseCache::Stats ResponseCache::stats() const {
+    std::size_t entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries = lru_.size();
+    }
+    return Stats{hits_.load(), misses_.load(), evictions_.load(), stale_.load(), entries, capacity_};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * @file responsecache.h
+ * @brief LRU cache of serialized API responses.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Holds response bodies keyed by normalized query parameters. Each entry
+ * remembers the Db data version and time bucket it was built in and is
+ * only served while both still match; the data version follows the
+ * database file, so writes by another process make entries stale too.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Thread-safe LRU cache of response bodies.
+ *
+ * Bodies are shared, so a hit copies the body outside the lock.
+ * A capacity of 0 disables the cache (every lookup misses, nothing is kept).
+ */
+class ResponseCache {
+public:
+    /** @brief Counters reported by /admin/cache-stats. */
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;   ///< entries dropped to make room (LRU)
+        std::uint64_t stale;       ///< entries dropped because a write or time bucket passed
+        std::size_t entries;
+        std::size_t capacity;
+    };
+
+    /** @param capacity Maximum number of cached responses. */
+    explicit ResponseCache(std::size_t capacity);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * @brief Looks up a response.
+     * @param key Normalized request key.
+     * @param version Current Db::dataVersion() (moves on commits from any process).
+     * @param bucket Current time bucket.
+     * @return The cached body, or null on a miss or stale entry.
+     */
+    std::shared_ptr<const std::string> get(const std::string& key, std::uint64_t version, std::int64_t bucket);
+
+    /**
+     * @brief Stores a response built at (version, bucket).
+     *
+     * version must have been read before the data the body was built from,
+     * so a write that lands meanwhile makes the entry stale, not wrong.
+     */
+    void put(const std::string& key, std::uint64_t version, std::int64_t bucket,
+             std::shared_ptr<const std::string> body);
+
+    /** @brief Returns a snapshot of the counters. */
+    Stats stats() const;
+
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        std::string key;
+        std::uint64_t version;
+        std::int64_t bucket;
+        std::shared_ptr<const std::string> body;
+    };
+
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> stale_{0};
+};
@@ -36,6 +36,7 @@ CREATE TABLE IF NOT EXISTS Flight (
   gate TEXT NOT NULL,
   passengerCount INTEGER NOT NULL,
   departureTime TEXT NOT NULL,
+  departureEpoch INTEGER,  -- departureTime as UTC seconds; written by Db with departureTime
   FOREIGN KEY (planeID) REFERENCES Plane(planeID),
   FOREIGN KEY (originAirportID) REFERENCES Airport(airportID),
   FOREIGN KEY (destinationAirportID) REFERENCES Airport(airportID),
@@ -48,4 +49,193 @@ CREATE INDEX IF NOT EXISTS idx_flight_departureTime ON Flight(departureTime);
 CREATE INDEX IF NOT EXISTS idx_flight_gate ON Flight(gate);
 CREATE INDEX IF NOT EXISTS idx_flight_airlineID ON Flight(airlineID);
 CREATE INDEX IF NOT EXISTS idx_flight_originAirportID ON Flight(originAirportID);
-CREATE INDEX IF NOT EXISTS idx_flight_destinationAirportID ON Flight(destinationAirportID);
\ No newline at end of file
+CREATE INDEX IF NOT EXISTS idx_flight_destinationAirportID ON Flight(destinationAirportID);
+
+
+-- Denormalized flights board: one row per flight with everything the list
+-- endpoints show, so reads never join the reference tables.
+-- Maintained by the triggers below whenever Flight or a reference row changes.
+CREATE TABLE IF NOT EXISTS FlightBoard (
+  flightID INTEGER PRIMARY KEY,
+  gate TEXT NOT NULL,
+  passengerCount INTEGER NOT NULL,
+  departureTime TEXT NOT NULL,
+  planeModel TEXT NOT NULL,
+  planeSpeed INTEGER NOT NULL,
+  airlineName TEXT NOT NULL,
+  airlineLogo TEXT NOT NULL,
+  originCode TEXT NOT NULL,
+  destCode TEXT NOT NULL,
+  originCity TEXT NOT NULL,
+  destCity TEXT NOT NULL,
+  originLat REAL NOT NULL,
+  originLon REAL NOT NULL,
+  destLat REAL NOT NULL,
+  destLon REAL NOT NULL,
+  departureEpoch INTEGER
+);
+
+-- (sort key, rowid) indexes: keyset seeks, time windows and windowed counts
+-- are range scans that never touch the table. Departure order and time
+-- windows use the integer epoch; the text column is only displayed.
+DROP INDEX IF EXISTS idx_board_departureTime;
+CREATE INDEX IF NOT EXISTS idx_board_departureEpoch ON FlightBoard(departureEpoch);
+CREATE INDEX IF NOT EXISTS idx_board_gate ON FlightBoard(gate);
+
+-- column order must match FlightBoard (the triggers insert SELECT *);
+-- recreated every start so databases upgraded by ALTER TABLE pick up new columns
+DROP VIEW IF EXISTS FlightBoardSource;
+CREATE VIEW FlightBoardSource AS
+SELECT f.flightID, f.gate, f.passengerCount, f.departureTime,
+       p.model, p.speed, al.name, al.logoPath,
+       oa.code, da.code, oc.name, dc.name,
+       oc.latitude, oc.longitude, dc.latitude, dc.longitude,
+       f.departureEpoch
+FROM Flight f
+JOIN Plane p    ON f.planeID = p.planeID
+JOIN Airline al ON f.airlineID = al.airlineID
+JOIN Airport oa ON f.originAirportID = oa.airportID
+JOIN Airport da ON f.destinationAirportID = da.airportID
+JOIN Cities oc  ON oa.cityID = oc.cityID
+JOIN Cities dc  ON da.cityID = dc.cityID;
+
+CREATE TRIGGER IF NOT EXISTS trg_flight_board_insert AFTER INSERT ON Flight
+BEGIN
+  INSERT INTO FlightBoard SELECT * FROM FlightBoardSource WHERE flightID = NEW.flightID;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flight_board_update AFTER UPDATE ON Flight
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID = OLD.flightID;
+  INSERT INTO FlightBoard SELECT * FROM FlightBoardSource WHERE flightID = NEW.flightID;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_flight_board_delete AFTER DELETE ON Flight
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID = OLD.flightID;
+END;
+
+-- reference rows rarely change, but when they do rebuild the board rows using them
+CREATE TRIGGER IF NOT EXISTS trg_airline_board_update AFTER UPDATE ON Airline
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID IN (SELECT flightID FROM Flight WHERE airlineID = NEW.airlineID);
+  INSERT INTO FlightBoard SELECT s.* FROM FlightBoardSource s JOIN Flight f ON f.flightID = s.flightID
+  WHERE f.airlineID = NEW.airlineID;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_plane_board_update AFTER UPDATE ON Plane
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID IN (SELECT flightID FROM Flight WHERE planeID = NEW.planeID);
+  INSERT INTO FlightBoard SELECT s.* FROM FlightBoardSource s JOIN Flight f ON f.flightID = s.flightID
+  WHERE f.planeID = NEW.planeID;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_airport_board_update AFTER UPDATE ON Airport
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID IN (
+    SELECT flightID FROM Flight
+    WHERE originAirportID = NEW.airportID OR destinationAirportID = NEW.airportID);
+  INSERT INTO FlightBoard SELECT s.* FROM FlightBoardSource s JOIN Flight f ON f.flightID = s.flightID
+  WHERE f.originAirportID = NEW.airportID OR f.destinationAirportID = NEW.airportID;
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_cities_board_update AFTER UPDATE ON Cities
+BEGIN
+  DELETE FROM FlightBoard WHERE flightID IN (
+    SELECT f.flightID FROM Flight f
+    JOIN Airport a ON a.airportID IN (f.originAirportID, f.destinationAirportID)
+    WHERE a.cityID = NEW.cityID);
+  INSERT INTO FlightBoard SELECT s.* FROM FlightBoardSource s
+  WHERE s.flightID IN (
+    SELECT f.flightID FROM Flight f
+    JOIN Airport a ON a.airportID IN (f.originAirportID, f.destinationAirportID)
+    WHERE a.cityID = NEW.cityID);
+END;
+
+-- backfill flights created before the board existed
+INSERT INTO FlightBoard SELECT * FROM FlightBoardSource
+WHERE flightID NOT IN (SELECT flightID FROM FlightBoard);
+
+
+-- Full-text search index for the flights board search box.
+-- One row per flight (rowid = flightID) holding every searchable column.
+-- The trigram tokenizer lets MATCH answer the same case-insensitive
+-- substring queries the old LOWER(col) LIKE '%x%' filters did.
+CREATE VIRTUAL TABLE IF NOT EXISTS FlightSearch USING fts5(
+  airline, originCity, destCity, originCode, destCode, gate, planeModel,
+  tokenize = 'trigram'
+);
+
+-- the search index used to be fed straight from the Flight join; it now follows FlightBoard
+DROP TRIGGER IF EXISTS trg_flight_search_insert;
+DROP TRIGGER IF EXISTS trg_flight_search_update;
+DROP TRIGGER IF EXISTS trg_flight_search_delete;
+DROP TRIGGER IF EXISTS trg_airline_search_update;
+DROP TRIGGER IF EXISTS trg_plane_search_update;
+DROP TRIGGER IF EXISTS trg_airport_search_update;
+DROP TRIGGER IF EXISTS trg_cities_search_update;
+DROP VIEW IF EXISTS FlightSearchSource;
+
+-- keep FlightSearch in sync with FlightBoard
+CREATE TRIGGER IF NOT EXISTS trg_board_search_insert AFTER INSERT ON FlightBoard
+BEGIN
+  INSERT INTO FlightSearch(rowid, airline, originCity, destCity, originCode, destCode, gate, planeModel)
+  VALUES (NEW.flightID, NEW.airlineName, NEW.originCity, NEW.destCity,
+          NEW.originCode, NEW.destCode, NEW.gate, NEW.planeModel);
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_board_search_delete AFTER DELETE ON FlightBoard
+BEGIN
+  DELETE FROM FlightSearch WHERE rowid = OLD.flightID;
+END;
+
+-- backfill flights created before the index existed
+INSERT INTO FlightSearch(rowid, airline, originCity, destCity, originCode, destCode, gate, planeModel)
+SELECT flightID, airlineName, originCity, destCity, originCode, destCode, gate, planeModel
+FROM FlightBoard
+WHERE flightID NOT IN (SELECT rowid FROM FlightSearch);
+
+
+-- Change log for delta sync (GET /api/flights/changes?since=N).
+-- One row per flight holding the version of its latest change; deleted
+-- flights stay as tombstones. Versions come from one counter (the current
+-- maximum + 1; every write goes through the single writer connection), so
+-- "changed after N" is a range scan on idx_flightchange_version. It follows
+-- FlightBoard, so rebuilds after reference-table updates are changes too.
+CREATE TABLE IF NOT EXISTS FlightChange (
+  flightID INTEGER PRIMARY KEY,
+  version INTEGER NOT NULL,
+  deleted INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX IF NOT EXISTS idx_flightchange_version ON FlightChange(version);
+
+-- backfill flights created before the log existed (only when it is empty)
+INSERT INTO FlightChange(flightID, version, deleted)
+SELECT flightID, flightID, 0 FROM FlightBoard
+WHERE NOT EXISTS (SELECT 1 FROM FlightChange);
+
+CREATE TRIGGER IF NOT EXISTS trg_board_change_insert AFTER INSERT ON FlightBoard
+BEGIN
+  INSERT OR REPLACE INTO FlightChange(flightID, version, deleted)
+  VALUES (NEW.flightID, (SELECT IFNULL(MAX(version), 0) + 1 FROM FlightChange), 0);
+END;
+
+CREATE TRIGGER IF NOT EXISTS trg_board_change_delete AFTER DELETE ON FlightBoard
+BEGIN
+  INSERT OR REPLACE INTO FlightChange(flightID, version, deleted)
+  VALUES (OLD.flightID, (SELECT IFNULL(MAX(version), 0) + 1 FROM FlightChange), 1);
+END;
+
+-- departureTime is stored as "YYYY-MM-DDTHH:MM:SS" (UTC); rows written
+-- before writes were normalized may hold "...Z", ".000Z" or a space separator
+UPDATE Flight
+SET departureTime = strftime('%Y-%m-%dT%H:%M:%S', departureTime)
+WHERE departureTime NOT GLOB '[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9]T[0-9][0-9]:[0-9][0-9]:[0-9][0-9]'
+  AND strftime('%Y-%m-%dT%H:%M:%S', departureTime) IS NOT NULL;
+
+-- departureEpoch backfill for rows written before the column existed
+-- (the Flight update trigger refreshes their board rows)
+UPDATE Flight
+SET departureEpoch = CAST(strftime('%s', departureTime) AS INTEGER)
+WHERE departureEpoch IS NULL
+  AND strftime('%s', departureTime) IS NOT NULL;
@@ -0,0 +1,166 @@
+/**
+ * @file slowquerylog.cpp
+ * @brief Implementation of the slow-query log.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "slowquerylog.h"
+#include "timeutil.h"
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// statement text on one line: whitespace runs (indentation, newlines) become one space
+static std::string oneLine(const std::string& sql) {
+    std::string out;
+    out.reserve(sql.size());
+    for (char c : sql) {
+        const bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        if (space && (out.empty() || out.back() == ' ')) continue;
+        out += space ? ' ' : c;
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+SlowQueryLog::SlowQueryLog(const std::string& dbPath, Options options)
+    : dbPath_(dbPath), options_(std::move(options)), writer_([this] { writeLoop(); }) {}
+
+SlowQueryLog::~SlowQueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stop_ = true;
+    }
+    queueCv_.notify_one();
+    writer_.join();
+    if (explainConn_) sqlite3_close(explainConn_);
+}
+
+void SlowQueryLog::record(Entry entry) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queue_.size() >= options_.maxQueued) {
+            dropped_++;
+            return;
+        }
+        queue_.push_back(std::move(entry));
+    }
+    queueCv_.notify_one();
+}
+
+SlowQueryLog::Stats SlowQueryLog::stats() const {
+    return Stats{logged_.load(), dropped_.load()};
+}
+
+void SlowQueryLog::writeLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    for (;;) {
+        queueCv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) return;   // stopping and drained
+
+        Entry entry = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        try {
+            write(entry);
+            logged_++;
+        } catch (const std::exception& e) {
+            std::cerr << "slow query log write failed: " << e.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+void SlowQueryLog::write(const Entry& entry) {
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(entry.at.time_since_epoch()).count();
+    char at[timeutil::kIso8601UtcLength];
+    timeutil::formatIso8601Utc(seconds, at);
+
+    std::ostringstream out;
+    out << std::string(at, sizeof(at))
+        << " " << static_cast<double>(entry.elapsedNs) / 1e6 << " ms"
+        << " rows=" << entry.rows
+        << " vmSteps=" << entry.vmSteps
+        << " fullScanSteps=" << entry.fullScanSteps << '\n'
+        << "  sql: " << oneLine(entry.expandedSql.empty() ? entry.sql : entry.expandedSql) << '\n'
+        << "  plan:\n" << explain(entry) << '\n';
+    const std::string text = out.str();
+
+    openFile(text.size());
+    file_ << text;
+    file_.flush();
+    fileBytes_ += text.size();
+}
+
+std::string SlowQueryLog::explain(const Entry& entry) {
+    if (!explainConn_) {
+        if (sqlite3_open_v2(dbPath_.c_str(), &explainConn_, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+            std::string msg = explainConn_ ? sqlite3_errmsg(explainConn_) : "out of memory";
+            sqlite3_close(explainConn_);
+            explainConn_ = nullptr;
+            return "    (unavailable: " + msg + ")\n";
+        }
+        sqlite3_busy_timeout(explainConn_, 5000);
+    }
+
+    // with the bound values inlined the plan is the one those values got
+    // (a LIKE prefix or a range can pick a different index than NULLs would)
+    const std::string& sql = entry.expandedSql.empty() ? entry.sql : entry.expandedSql;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(explainConn_, ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::string msg = sqlite3_errmsg(explainConn_);
+        sqlite3_finalize(stmt);
+        return "    (unavailable: " + msg + ")\n";
+    }
+
+    // rows are (id, parent, notused, detail); indent each under its parent
+    std::string plan;
+    std::unordered_map<int, int> depth;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const int id = sqlite3_column_int(stmt, 0);
+        const int parent = sqlite3_column_int(stmt, 1);
+        auto it = depth.find(parent);
+        const int d = it == depth.end() ? 0 : it->second + 1;
+        depth[id] = d;
+
+        const auto detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        plan.append(4 + 2 * static_cast<std::size_t>(d), ' ');
+        plan += detail ? detail : "";
+        plan += '\n';
+    }
+    sqlite3_finalize(stmt);
+    return plan.empty() ? "    (no plan)\n" : plan;
+}
+
+void SlowQueryLog::openFile(std::uintmax_t incoming) {
+    if (!file_.is_open()) {
+        std::error_code ec;
+        fileBytes_ = fs::exists(options_.path, ec) ? fs::file_size(options_.path, ec) : 0;
+        if (ec) fileBytes_ = 0;
+        file_.open(options_.path, std::ios::out | std::ios::app | std::ios::binary);
+        if (!file_) throw std::runtime_error("Failed to open slow query log " + options_.path);
+    }
+    if (fileBytes_ == 0 || fileBytes_ + incoming <= options_.maxBytes) return;
+
+    // log.N is dropped, log.i -> log.i+1, log -> log.1 (keepFiles 0 just truncates)
+    file_.close();
+    const int keep = options_.keepFiles;
+    if (keep > 0) {
+        std::error_code ec;
+        fs::remove(options_.path + "." + std::to_string(keep), ec);
+        for (int i = keep - 1; i >= 1; --i) {
+            fs::rename(options_.path + "." + std::to_string(i), options_.path + "." + std::to_string(i + 1), ec);
+        }
+        fs::rename(options_.path, options_.path + ".1", ec);
+    }
+
+    file_.open(options_.path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file_) throw std::runtime_error("Failed to open slow query log " + options_.path);
+    fileBytes_ = 0;
+}
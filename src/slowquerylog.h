@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file slowquerylog.h
+ * @brief Log of SQL statements that ran longer than a threshold.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Each entry has the statement with its bound values, how long it took
+ * and the EXPLAIN QUERY PLAN output, so a search term or date filter that
+ * turned a range scan into a full scan shows up without reproducing it.
+ */
+
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Background writer of the slow-query log.
+ *
+ * Db reports slow statements from its trace callback with record(), which
+ * only queues them; a thread of its own explains each one on a separate
+ * read-only connection and appends it to the log file. When the file
+ * grows past maxBytes it is rotated (log -> log.1 -> log.2 ...).
+ */
+class SlowQueryLog {
+public:
+    /** @brief Tuning knobs. */
+    struct Options {
+        std::chrono::nanoseconds threshold = std::chrono::milliseconds(100);   ///< log statements at least this slow
+        std::string path;                              ///< log file
+        std::uintmax_t maxBytes = 10 * 1024 * 1024;    ///< rotate past this size
+        int keepFiles = 3;                             ///< rotated files kept (log.1 .. log.N)
+        std::size_t maxQueued = 1000;                  ///< entries past this are dropped
+    };
+
+    /** @brief One slow statement, as seen by the trace callback. */
+    struct Entry {
+        std::chrono::system_clock::time_point at;
+        std::string sql;            ///< as prepared, with parameters
+        std::string expandedSql;    ///< with the bound values inlined (sqlite3_expanded_sql)
+        std::uint64_t elapsedNs = 0;
+        std::uint64_t rows = 0;
+        std::uint64_t vmSteps = 0;
+        std::uint64_t fullScanSteps = 0;
+    };
+
+    /** @brief Counters reported by /admin/sql-stats. */
+    struct Stats {
+        std::uint64_t logged;
+        std::uint64_t dropped;   ///< queue full
+    };
+
+    /**
+     * @param dbPath Database to explain statements against; opened read-only
+     *        on first use, so the file may not exist yet.
+     */
+    SlowQueryLog(const std::string& dbPath, Options options);
+
+    /** @brief Writes what is still queued and stops the writer thread. */
+    ~SlowQueryLog();
+
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    std::chrono::nanoseconds threshold() const { return options_.threshold; }
+
+    /** @brief Queues an entry; never blocks on the file or the database. */
+    void record(Entry entry);
+
+    Stats stats() const;
+
+private:
+    const std::string dbPath_;
+    const Options options_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<Entry> queue_;
+    bool stop_ = false;
+
+    std::atomic<std::uint64_t> logged_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    // writer thread only
+    sqlite3* explainConn_ = nullptr;
+    std::ofstream file_;
+    std::uintmax_t fileBytes_ = 0;
+
+    std::thread writer_;
+
+    void writeLoop();
+    void write(const Entry& entry);
+
+    /** @brief EXPLAIN QUERY PLAN as an indented tree, or why it failed. */
+    std::string explain(const Entry& entry);
+
+    /** @brief Opens the log for appending, rotating it first if it is full. */
+    void openFile(std::uintmax_t incoming);
+};
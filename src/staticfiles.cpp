@@ -0,0 +1,210 @@
+/**
+ * @file staticfiles.cpp
+ * @brief Implementation of the in-memory static file store.
+ * @authors Everyone is an author baby this is a team effort
+ */
+
+#include "staticfiles.h"
+#include "timeutil.h"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// startup-only, so spend the CPU on the best ratio
+constexpr int kPrecompressLevel = 9;
+
+// quiet period after the last inotify event before reloading
+constexpr auto kReloadDebounce = std::chrono::milliseconds(200);
+
+constexpr std::uint32_t kWatchMask =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+// keep a variant only if it saves at least a tenth of the bytes
+std::string precompress(const std::string& body, compression::Encoding encoding) {
+    std::string out = compression::compress(body, encoding, kPrecompressLevel);
+    if (out.size() * 10 > body.size() * 9) out.clear();
+    return out;
+}
+
+struct MimeType {
+    const char* contentType;
+    bool compressible;   // already-compressed formats are not worth running zlib on
+};
+
+MimeType mimeTypeFor(const fs::path& path) {
+    static const std::unordered_map<std::string, MimeType> types = {
+        {".html",  {"text/html; charset=utf-8", true}},
+        {".htm",   {"text/html; charset=utf-8", true}},
+        {".css",   {"text/css; charset=utf-8", true}},
+        {".js",    {"application/javascript; charset=utf-8", true}},
+        {".json",  {"application/json", true}},
+        {".txt",   {"text/plain; charset=utf-8", true}},
+        {".svg",   {"image/svg+xml", true}},
+        {".ico",   {"image/x-icon", true}},
+        {".png",   {"image/png", false}},
+        {".gif",   {"image/gif", false}},
+        {".jpg",   {"image/jpeg", false}},
+        {".jpeg",  {"image/jpeg", false}},
+        {".webp",  {"image/webp", false}},
+        {".woff",  {"font/woff", false}},
+        {".woff2", {"font/woff2", false}},
+    };
+    std::string ext = path.extension().string();
+    for (auto& c : ext) if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    auto it = types.find(ext);
+    return it == types.end() ? MimeType{"application/octet-stream", false} : it->second;
+}
+
+// 64-bit FNV-1a of the file contents, as a quoted hex entity tag
+std::string contentTag(const std::string& body) {
+    std::uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : body) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char buf[16];
+    auto end = std::to_chars(buf, buf + sizeof(buf), h, 16).ptr;
+    return "\"" + std::string(buf, end) + "\"";
+}
+
+}
+
+const std::string& StaticFiles::File::variant(compression::Encoding encoding,
+                                              compression::Encoding& used) const {
+    if (encoding == compression::Encoding::Gzip && !gzip.empty()) {
+        used = encoding;
+        return gzip;
+    }
+    if (encoding == compression::Encoding::Deflate && !deflate.empty()) {
+        used = encoding;
+        return deflate;
+    }
+    used = compression::Encoding::Identity;
+    return body;
+}
+
+std::string StaticFiles::File::etagFor(compression::Encoding encoding) const {
+    if (encoding == compression::Encoding::Identity) return etag;
+    return etag.substr(0, etag.size() - 1) + '-' + compression::encodingName(encoding) + '"';
+}
+
+StaticFiles::StaticFiles(const std::string& root, std::size_t minBytes)
+    : root_(root), minBytes_(minBytes), tree_(load()) {}
+
+StaticFiles::~StaticFiles() {
+    stop_ = true;
+    if (watcher_.joinable()) watcher_.join();
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+}
+
+std::shared_ptr<const StaticFiles::Tree> StaticFiles::load() const {
+    auto tree = std::make_shared<Tree>();
+
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root_, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const auto name = it->path().filename().string();
+        if (!name.empty() && name[0] == '.') {
+            if (it->is_directory()) it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file()) continue;
+
+        std::ifstream in(it->path(), std::ios::in | std::ios::binary);
+        if (!in) continue;
+
+        const MimeType mime = mimeTypeFor(it->path());
+        File file;
+        file.body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (mime.compressible && file.body.size() >= minBytes_) {
+            file.gzip = precompress(file.body, compression::Encoding::Gzip);
+            file.deflate = precompress(file.body, compression::Encoding::Deflate);
+        }
+        file.contentType = mime.contentType;
+        file.etag = contentTag(file.body);
+
+        // file_clock -> system_clock without C++20 clock_cast
+        std::error_code timeEc;
+        const auto mtime = fs::last_write_time(it->path(), timeEc);
+        if (!timeEc) {
+            const auto sys = std::chrono::system_clock::now()
+                + std::chrono::duration_cast<std::chrono::system_clock::duration>(mtime - fs::file_time_type::clock::now());
+            file.modifiedEpoch = std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count();
+        }
+        char date[timeutil::kHttpDateLength];
+        file.lastModified.assign(date, timeutil::formatHttpDate(file.modifiedEpoch, date));
+
+        tree->emplace(fs::relative(it->path(), root_).generic_string(), std::move(file));
+    }
+    return tree;
+}
+
+std::shared_ptr<const StaticFiles::File> StaticFiles::find(const std::string& path) const {
+    auto tree = std::atomic_load(&tree_);
+    auto it = tree->find(path);
+    if (it == tree->end()) return nullptr;
+    return std::shared_ptr<const File>(tree, &it->second);
+}
+
+void StaticFiles::reload() {
+    std::atomic_store(&tree_, load());
+}
+
+std::size_t StaticFiles::fileCount() const {
+    return std::atomic_load(&tree_)->size();
+}
+
+bool StaticFiles::watch() {
+    if (watcher_.joinable()) return true;
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) return false;
+
+    watcher_ = std::thread([this] { watchLoop(); });
+    return true;
+}
+
+void StaticFiles::watchLoop() {
+    // (re)adds a watch on root and every directory below it; adding an
+    // existing watch only updates it, and removed directories drop out
+    auto addWatches = [this] {
+        inotify_add_watch(inotifyFd_, root_.c_str(), kWatchMask);
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root_, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory()) inotify_add_watch(inotifyFd_, it->path().c_str(), kWatchMask);
+        }
+    };
+    addWatches();
+
+    bool pending = false;
+    auto lastEvent = std::chrono::steady_clock::now();
+    char events[4096];
+
+    while (!stop_) {
+        pollfd pfd{inotifyFd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) > 0) {
+            while (read(inotifyFd_, events, sizeof(events)) > 0) {}
+            pending = true;
+            lastEvent = std::chrono::steady_clock::now();
+        }
+
+        if (pending && std::chrono::steady_clock::now() - lastEvent >= kReloadDebounce) {
+            pending = false;
+            addWatches();
+            try {
+                reload();
+            } catch (const std::exception& e) {
+                std::cerr << "static file reload failed: " << e.what() << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * @file staticfiles.h
+ * @brief In-memory store of the files under /public.
+ * @authors Everyone is an author baby this is a team effort
+ *
+ * Loads the static tree at startup, together with gzip and deflate
+ * variants of every file that compresses well, so requests never touch
+ * the disk or run zlib. The tree can optionally be reloaded when files
+ * change (inotify).
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "compression.h"
+
+/**
+ * @brief Static files loaded into memory.
+ *
+ * Each load builds an immutable snapshot; readers take a reference to the
+ * current one without locking, and a reload swaps in a new snapshot while
+ * requests still holding the old one finish with it.
+ */
+class StaticFiles {
+public:
+    /** @brief One file, its precompressed variants and its validators. */
+    struct File {
+        std::string body;
+        std::string gzip;          ///< empty if compressing did not pay off
+        std::string deflate;       ///< empty if compressing did not pay off
+        std::string contentType;   ///< from the file extension
+        std::string etag;          ///< quoted content hash of body
+        std::string lastModified;  ///< HTTP date of the file's mtime
+        std::int64_t modifiedEpoch = 0;
+
+        /**
+         * @brief Returns the stored representation to send for an encoding.
+         * @param encoding Negotiated encoding; falls back to identity when
+         *        that variant was not kept.
+         * @param used Encoding actually returned.
+         */
+        const std::string& variant(compression::Encoding encoding, compression::Encoding& used) const;
+
+        /** @brief Entity tag of a variant (each encoding gets its own strong tag). */
+        std::string etagFor(compression::Encoding encoding) const;
+    };
+
+    /**
+     * @brief Loads every regular file under root (dotfiles skipped).
+     * @param root Directory to load, e.g. "/app/public".
+     * @param minBytes Files smaller than this are not precompressed.
+     */
+    StaticFiles(const std::string& root, std::size_t minBytes);
+
+    /** @brief Stops the reload watcher, if running. */
+    ~StaticFiles();
+
+    StaticFiles(const StaticFiles&) = delete;
+    StaticFiles& operator=(const StaticFiles&) = delete;
+
+    /**
+     * @brief Finds a file by its path relative to root ("styles/main.css").
+     * @return The file (keeping its snapshot alive), or null if it was not loaded.
+     */
+    std::shared_ptr<const File> find(const std::string& path) const;
+
+    /** @brief Re-reads the whole tree and swaps it in. */
+    void reload();
+
+    /**
+     * @brief Reloads the tree whenever a file under root changes.
+     *
+     * Runs an inotify watcher thread; bursts of events (an editor saving,
+     * a deploy copying files) are coalesced into one reload.
+     * @return False if inotify is unavailable.
+     */
+    bool watch();
+
+    /** @brief Number of files in the current snapshot. */
+    std::size_t fileCount() const;
+
+private:
+    using Tree = std::unordered_map<std::string, File>;
+
+    const std::string root_;
+    const std::size_t minBytes_;
+    std::shared_ptr<const Tree> tree_;   // accessed with std::atomic_load/atomic_store
+
+    std::thread watcher_;
+    std::atomic<bool> stop_{false};
+    int inotifyFd_ = -1;
+
+    std::shared_ptr<const Tree> load() const;
+    void watchLoop();
+};
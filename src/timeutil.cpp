@@ -5,57 +5,231 @@
  */
 
 #include "timeutil.h"
-#include <ctime>
-#include <iomanip>
-#include <sstream>
 
 namespace timeutil {
 
-static std::string normalizeIso(const std::string& iso) {
-    // Keep only up to seconds, remove milliseconds and trailing Z if present.
-    // Example: 2026-02-11T01:29:13.123Z -> 2026-02-11T01:29:13
-    std::string s = iso;
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil). Works for any day number, so d = 31 in a 30-day month
+// lands on the 1st of the next month.
+static std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);                 // [0, 399]
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;     // [0, 365]
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;               // [0, 146096]
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+// Inverse of daysFromCivil.
+static void civilFromDays(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// Reads minDigits..maxDigits decimal digits at s[pos]; advances pos.
+static bool readNumber(std::string_view s, std::size_t& pos, std::size_t minDigits,
+                       std::size_t maxDigits, unsigned& out) {
+    std::size_t n = 0;
+    out = 0;
+    while (n < maxDigits && pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+        out = out * 10 + static_cast<unsigned>(s[pos] - '0');
+        ++pos;
+        ++n;
+    }
+    return n >= minDigits;
+}
 
-    // Drop trailing 'Z'
-    if (!s.empty() && s.back() == 'Z') s.pop_back();
+static bool expect(std::string_view s, std::size_t& pos, char c) {
+    if (pos >= s.size() || s[pos] != c) return false;
+    ++pos;
+    return true;
+}
+
+bool parseIso8601Utc(std::string_view iso, std::int64_t& epochSeconds) {
+    std::size_t pos = 0;
+    unsigned year, month, day, hour, minute, second;
 
-    // Drop fractional seconds
-    auto dot = s.find('.');
-    if (dot != std::string::npos) s = s.substr(0, dot);
+    if (!readNumber(iso, pos, 1, 4, year) || !expect(iso, pos, '-')) return false;
+    if (!readNumber(iso, pos, 1, 2, month) || !expect(iso, pos, '-')) return false;
+    if (!readNumber(iso, pos, 1, 2, day) || !expect(iso, pos, 'T')) return false;
+    if (!readNumber(iso, pos, 1, 2, hour) || !expect(iso, pos, ':')) return false;
+    if (!readNumber(iso, pos, 1, 2, minute) || !expect(iso, pos, ':')) return false;
+    if (!readNumber(iso, pos, 1, 2, second)) return false;
 
-    return s;
+    // same field ranges std::get_time accepted (60 = leap second)
+    if (month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    epochSeconds = daysFromCivil(year, month, day) * 86400 +
+                   hour * 3600 + minute * 60 + second;
+    return true;
 }
 
-bool parseIso8601Utc(const std::string& iso, std::chrono::system_clock::time_point& out) {
-    const std::string s = normalizeIso(iso);
+bool parseDateTime(std::string_view s, std::int64_t& epochSeconds) {
+    std::size_t pos = 0;
+    unsigned year, month, day, hour = 0, minute = 0, second = 0;
 
-    std::tm tm{};
-    std::istringstream ss(s);
-    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-    if (ss.fail()) return false;
+    if (!readNumber(s, pos, 4, 4, year) || !expect(s, pos, '-')) return false;
+    if (!readNumber(s, pos, 2, 2, month) || !expect(s, pos, '-')) return false;
+    if (!readNumber(s, pos, 2, 2, day)) return false;
+
+    if (pos < s.size()) {
+        if (s[pos] != 'T' && s[pos] != ' ') return false;
+        ++pos;
+        if (!readNumber(s, pos, 2, 2, hour) || !expect(s, pos, ':')) return false;
+        if (!readNumber(s, pos, 2, 2, minute)) return false;
+        if (pos < s.size() && s[pos] == ':') {
+            ++pos;
+            if (!readNumber(s, pos, 2, 2, second)) return false;
+        }
+
+        // optional fraction and UTC marker; the fraction is dropped
+        if (pos < s.size() && s[pos] == '.') {
+            unsigned ignored;
+            ++pos;
+            while (readNumber(s, pos, 1, 9, ignored)) {}
+        }
+        if (pos < s.size() && s[pos] == 'Z') ++pos;
+        if (pos != s.size()) return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    epochSeconds = daysFromCivil(year, month, day) * 86400 +
+                   hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+bool parseIso8601Utc(std::string_view iso, std::chrono::system_clock::time_point& out) {
+    std::int64_t t;
+    if (!parseIso8601Utc(iso, t)) return false;
+    out = std::chrono::system_clock::time_point(std::chrono::seconds(t));
+    return true;
+}
+
+static char* writeDigits(char* p, unsigned v, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    }
+    return p + width;
+}
+
+char* formatDateTime(std::int64_t epochSeconds, char* out) {
+    std::int64_t days = epochSeconds / 86400;
+    std::int64_t secs = epochSeconds % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        --days;
+    }
+
+    std::int64_t y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+
+    char* p = writeDigits(out, static_cast<unsigned>(y), 4);
+    *p++ = '-';
+    p = writeDigits(p, m, 2);
+    *p++ = '-';
+    p = writeDigits(p, d, 2);
+    *p++ = 'T';
+    p = writeDigits(p, static_cast<unsigned>(secs / 3600), 2);
+    *p++ = ':';
+    p = writeDigits(p, static_cast<unsigned>(secs / 60 % 60), 2);
+    *p++ = ':';
+    return writeDigits(p, static_cast<unsigned>(secs % 60), 2);
+}
+
+char* formatIso8601Utc(std::int64_t epochSeconds, char* out) {
+    char* p = formatDateTime(epochSeconds, out);
+    *p++ = 'Z';
+    return p;
+}
+
+static const char kWeekdays[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char kMonths[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+char* formatHttpDate(std::int64_t epochSeconds, char* out) {
+    std::int64_t days = epochSeconds / 86400;
+    std::int64_t secs = epochSeconds % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        --days;
+    }
+
+    std::int64_t y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+    const std::int64_t weekday = ((days % 7) + 7 + 4) % 7;   // 1970-01-01 was a Thursday
+
+    char* p = out;
+    for (int i = 0; i < 3; ++i) *p++ = kWeekdays[weekday][i];
+    *p++ = ',';
+    *p++ = ' ';
+    p = writeDigits(p, d, 2);
+    *p++ = ' ';
+    for (int i = 0; i < 3; ++i) *p++ = kMonths[m - 1][i];
+    *p++ = ' ';
+    p = writeDigits(p, static_cast<unsigned>(y), 4);
+    *p++ = ' ';
+    p = writeDigits(p, static_cast<unsigned>(secs / 3600), 2);
+    *p++ = ':';
+    p = writeDigits(p, static_cast<unsigned>(secs / 60 % 60), 2);
+    *p++ = ':';
+    p = writeDigits(p, static_cast<unsigned>(secs % 60), 2);
+    *p++ = ' ';
+    *p++ = 'G';
+    *p++ = 'M';
+    *p++ = 'T';
+    return p;
+}
+
+bool parseHttpDate(std::string_view s, std::int64_t& epochSeconds) {
+    if (s.size() != kHttpDateLength || s.substr(3, 2) != ", " || s.substr(25) != " GMT") return false;
+
+    std::size_t pos = 5;
+    unsigned year, month = 0, day, hour, minute, second;
+    if (!readNumber(s, pos, 2, 2, day) || !expect(s, pos, ' ')) return false;
+    for (unsigned i = 0; i < 12; ++i) {
+        if (s.substr(pos, 3) == kMonths[i]) month = i + 1;
+    }
+    pos += 3;
+    if (month == 0 || !expect(s, pos, ' ')) return false;
+    if (!readNumber(s, pos, 4, 4, year) || !expect(s, pos, ' ')) return false;
+    if (!readNumber(s, pos, 2, 2, hour) || !expect(s, pos, ':')) return false;
+    if (!readNumber(s, pos, 2, 2, minute) || !expect(s, pos, ':')) return false;
+    if (!readNumber(s, pos, 2, 2, second)) return false;
+    if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) return false;
+
+    epochSeconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
 
-    // Interpret as UTC:
-#if defined(_WIN32)
-    std::time_t t = _mkgmtime(&tm);
-#else
-    std::time_t t = timegm(&tm);
-#endif
-    out = std::chrono::system_clock::from_time_t(t);
+bool normalizeDateTime(std::string_view s, std::string& out) {
+    std::int64_t t;
+    if (!parseDateTime(s, t)) return false;
+    char buf[kDateTimeLength];
+    out.assign(buf, formatDateTime(t, buf));
     return true;
 }
 
 std::string formatIso8601Utc(const std::chrono::system_clock::time_point& tp) {
-    std::time_t t = std::chrono::system_clock::to_time_t(tp);
-    std::tm tm{};
-#if defined(_WIN32)
-    gmtime_s(&tm, &t);
-#else
-    gmtime_r(&t, &tm);
-#endif
-
-    std::ostringstream out;
-    out << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
-    return out.str();
+    char buf[kIso8601UtcLength];
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    return std::string(buf, formatIso8601Utc(secs, buf));
 }
 
 }
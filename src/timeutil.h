@@ -5,11 +5,13 @@
  * @brief Time parsing and formatting utilities.
  * @authors Everyone is an author baby this is a team effort
  *
- * Handles ISO-8601 UTC conversions.
+ * Handles ISO-8601 UTC conversions and HTTP dates.
  */
 
 #include <chrono>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 /**
  * @brief Time utility functions for ISO-8601 parsing and formatting.
@@ -18,9 +20,35 @@
  *
  * Provides helpers for converting between UTC strings
  * and std::chrono time points.
+ *
+ * Parsing and formatting are done by hand with days-from-civil
+ * arithmetic: no streams, no locale, no heap allocation.
  */
 namespace timeutil {
 
+/** @brief Characters written by the buffer overload of formatIso8601Utc. */
+constexpr std::size_t kIso8601UtcLength = 20;
+
+/** @brief Characters written by formatDateTime ("YYYY-MM-DDTHH:MM:SS"). */
+constexpr std::size_t kDateTimeLength = 19;
+
+/** @brief Characters written by formatHttpDate ("Sun, 06 Nov 1994 08:49:37 GMT"). */
+constexpr std::size_t kHttpDateLength = 29;
+
+/**
+     * @brief Parses an ISO-8601 UTC string into seconds since the Unix epoch.
+     *
+     * Accepts "YYYY-MM-DDTHH:MM:SS" optionally followed by fractional
+     * seconds and/or 'Z' (anything after the seconds is ignored).
+     * Month/day/hour fields may have one or two digits. Out-of-range
+     * days roll over into the next month, like timegm.
+     *
+     * @param iso Input UTC timestamp.
+     * @param epochSeconds Output seconds since 1970-01-01T00:00:00Z.
+     * @return True if parsing was successful.
+     */
+    bool parseIso8601Utc(std::string_view iso, std::int64_t& epochSeconds);
+
 /**
      * @brief Parses an ISO-8601 UTC string into a time_point.
      * @author Mohammad Aljabrery
@@ -33,8 +61,65 @@ namespace timeutil {
      * @param out Output time_point if parsing succeeds.
      * @return True if parsing was successful.
      */
-    bool parseIso8601Utc(const std::string& iso, std::chrono::system_clock::time_point& out);
+    bool parseIso8601Utc(std::string_view iso, std::chrono::system_clock::time_point& out);
+
+/**
+     * @brief Formats seconds since the Unix epoch as "YYYY-MM-DDTHH:MM:SSZ".
+     * @param epochSeconds Seconds since 1970-01-01T00:00:00Z (years 0-9999).
+     * @param out Buffer of at least kIso8601UtcLength chars (not NUL-terminated).
+     * @return Pointer one past the last character written.
+     */
+    char* formatIso8601Utc(std::int64_t epochSeconds, char* out);
 
+/**
+     * @brief Parses a date or date-time as typed by users and clients.
+     *
+     * Accepts "YYYY-MM-DD" (midnight) or "YYYY-MM-DD[T| ]HH:MM[:SS]"
+     * optionally followed by fractional seconds and/or 'Z', so the
+     * browser's toISOString(), datetime-local inputs and SQLite's
+     * datetime() output all parse to the same instant (read as UTC).
+     *
+     * @param s Input text.
+     * @param epochSeconds Output seconds since 1970-01-01T00:00:00Z.
+     * @return True if s is one of the accepted forms.
+     */
+    bool parseDateTime(std::string_view s, std::int64_t& epochSeconds);
+
+/**
+     * @brief Formats seconds since the Unix epoch in the stored form "YYYY-MM-DDTHH:MM:SS".
+     * @param epochSeconds Seconds since 1970-01-01T00:00:00Z (years 0-9999).
+     * @param out Buffer of at least kDateTimeLength chars (not NUL-terminated).
+     * @return Pointer one past the last character written.
+     */
+    char* formatDateTime(std::int64_t epochSeconds, char* out);
+
+/**
+     * @brief Rewrites any form parseDateTime accepts as "YYYY-MM-DDTHH:MM:SS".
+     * @param s Input text.
+     * @param out Canonical form on success.
+     * @return True if s parsed.
+     */
+    bool normalizeDateTime(std::string_view s, std::string& out);
+
+/**
+     * @brief Formats seconds since the Unix epoch as an HTTP date (RFC 9110 IMF-fixdate).
+     * @param epochSeconds Seconds since 1970-01-01T00:00:00Z (years 0-9999).
+     * @param out Buffer of at least kHttpDateLength chars (not NUL-terminated).
+     * @return Pointer one past the last character written.
+     */
+    char* formatHttpDate(std::int64_t epochSeconds, char* out);
+
+/**
+     * @brief Parses an HTTP date such as If-Modified-Since.
+     *
+     * Only the IMF-fixdate form ("Sun, 06 Nov 1994 08:49:37 GMT") that
+     * every current client sends; the obsolete forms are rejected.
+     *
+     * @param s Input text.
+     * @param epochSeconds Output seconds since 1970-01-01T00:00:00Z.
+     * @return True if s parsed.
+     */
+    bool parseHttpDate(std::string_view s, std::int64_t& epochSeconds);
 
 /**
      * @brief Formats a UTC time_point into ISO-8601 string.